@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "s21_matrix.h"
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(matrix_t *A, unsigned seed) {
+  for (int i = 0; i < A->rows; i++) {
+    for (int j = 0; j < A->columns; j++) {
+      seed = seed * 1103515245u + 12345u;
+      A->matrix[i][j] = (double)(seed >> 8) / (1u << 24) - 0.5;
+    }
+    if (i < A->columns) {
+      A->matrix[i][i] += 1.0;
+    }
+  }
+}
+
+// determinant runs one lu factorization, 2/3 n^3 flops; one untimed call
+// first faults in the context's workspace
+static void bench_lu(int n, int max_threads) {
+  s21_context_t *ctx;
+  matrix_t A;
+  double det, start, elapsed, base = 0.0;
+
+  s21_context_create(&ctx);
+  s21_create_matrix(n, n, &A);
+  fill(&A, n);
+  s21_determinant_ctx(ctx, &A, &det);
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    s21_context_set_threads(ctx, threads);
+    start = now();
+    s21_determinant_ctx(ctx, &A, &det);
+    elapsed = now() - start;
+    if (threads == 1) {
+      base = elapsed;
+    }
+    printf("lu backend=%s n=%d threads=%d time=%.3fs gflops=%.2f "
+           "speedup=%.2f\n",
+           s21_backend(), n, threads, elapsed,
+           2.0 / 3.0 * n * n * (double)n / elapsed * 1e-9, base / elapsed);
+  }
+
+  s21_remove_matrix(&A);
+  s21_context_destroy(ctx);
+}
+
+// mult_matrix does 2 n^3 flops, plus one solve through inverse
+static void bench_gemm(int n, int max_threads) {
+  s21_context_t *ctx;
+  matrix_t A, B, C;
+  double start, elapsed;
+
+  s21_context_create(&ctx);
+  s21_context_set_threads(ctx, max_threads);
+  s21_create_matrix(n, n, &A);
+  s21_create_matrix(n, n, &B);
+  fill(&A, n);
+  fill(&B, n + 1);
+
+  start = now();
+  s21_mult_matrix_ctx(ctx, &A, &B, &C);
+  elapsed = now() - start;
+  printf("gemm backend=%s n=%d threads=%d time=%.3fs gflops=%.2f\n",
+         s21_backend(), n, max_threads, elapsed,
+         2.0 * n * n * (double)n / elapsed * 1e-9);
+  s21_remove_matrix(&C);
+
+  start = now();
+  s21_inverse_matrix_ctx(ctx, &A, &C);
+  elapsed = now() - start;
+  printf("inverse backend=%s n=%d threads=%d time=%.3fs\n", s21_backend(), n,
+         max_threads, elapsed);
+  s21_remove_matrix(&C);
+
+  s21_remove_matrix(&A);
+  s21_remove_matrix(&B);
+  s21_context_destroy(ctx);
+}
+
+// mult_matrix under each accumulation mode, slowdown relative to naive
+static void bench_accum(int n, int max_threads) {
+  const char *names[] = {"naive", "pairwise", "kahan", "dot2"};
+  s21_context_t *ctx;
+  matrix_t A, B, C;
+  double start, elapsed, base = 0.0;
+
+  s21_context_create(&ctx);
+  s21_context_set_threads(ctx, max_threads);
+  s21_create_matrix(n, n, &A);
+  s21_create_matrix(n, n, &B);
+  fill(&A, n);
+  fill(&B, n + 1);
+
+  for (int mode = ACCUM_NAIVE; mode <= ACCUM_DOT2; mode++) {
+    s21_context_set_accumulation(ctx, mode);
+    start = now();
+    s21_mult_matrix_ctx(ctx, &A, &B, &C);
+    elapsed = now() - start;
+    if (mode == ACCUM_NAIVE) {
+      base = elapsed;
+    }
+    printf("accum mode=%s n=%d threads=%d time=%.3fs slowdown=%.2f\n",
+           names[mode], n, max_threads, elapsed, elapsed / base);
+    s21_remove_matrix_ctx(ctx, &C);
+  }
+
+  s21_remove_matrix(&A);
+  s21_remove_matrix(&B);
+  s21_context_destroy(ctx);
+}
+
+// transpose and mult_matrix with malloc against hugepage first-touch storage
+static void bench_alloc(int n, int max_threads) {
+  const char *names[] = {"malloc", "hugepage"};
+  s21_context_t *ctx;
+  matrix_t A, B, C;
+  double start, transpose, mult;
+
+  for (int huge = 0; huge < 2; huge++) {
+    s21_context_create(&ctx);
+    s21_context_set_threads(ctx, max_threads);
+    if (huge) {
+      s21_context_set_allocator(ctx, s21_hugepage_allocator());
+      s21_context_set_first_touch(ctx, 1);
+    }
+    s21_create_matrix_ctx(ctx, n, n, &A);
+    fill(&A, n);
+
+    start = now();
+    s21_transpose_ctx(ctx, &A, &B);
+    transpose = now() - start;
+    start = now();
+    s21_mult_matrix_ctx(ctx, &A, &B, &C);
+    mult = now() - start;
+    printf("alloc %s n=%d threads=%d transpose=%.3fs mult=%.3fs\n",
+           names[huge], n, max_threads, transpose, mult);
+
+    s21_remove_matrix_ctx(ctx, &C);
+    s21_remove_matrix_ctx(ctx, &B);
+    s21_remove_matrix_ctx(ctx, &A);
+    s21_context_destroy(ctx);
+  }
+}
+
+// usage: bench_s21_matrix [lu|gemm|accum|alloc|all] [max threads] [n ...]
+int main(int argc, char **argv) {
+  int sizes[] = {512, 1024, 2048};
+  const char *which = argc > 1 ? argv[1] : "all";
+  int threads;
+
+  threads = argc > 2 ? atoi(argv[2]) : 0;
+  if (threads <= 0) {
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  // one worker per thread, so the bands of each run are spread over them
+  s21_async_init(threads);
+
+  for (int i = 0; i < (argc > 3 ? argc - 3 : 3); i++) {
+    int n = argc > 3 ? atoi(argv[i + 3]) : sizes[i];
+    if (strcmp(which, "lu") == 0 || strcmp(which, "all") == 0) {
+      bench_lu(n, threads);
+    }
+    if (strcmp(which, "gemm") == 0 || strcmp(which, "all") == 0) {
+      bench_gemm(n, threads);
+    }
+    if (strcmp(which, "accum") == 0) {
+      bench_accum(n, threads);
+    }
+    if (strcmp(which, "alloc") == 0) {
+      bench_alloc(n, threads);
+    }
+  }
+
+  s21_async_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,659 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <float.h>
+#include <string.h>
+#include <time.h>
+
+#include "s21_matrix.h"
+
+// random inputs for the optimized kernels are checked against the simple
+// cofactor/adjugate/triple-loop implementations the library started from,
+// then each kernel has to beat the unblocked single-threaded elimination or
+// triple loop by a configured factor
+
+#define MAX_SMALL 8
+#define LARGE_MIN 150
+#define LARGE_SPAN 110
+
+enum kinds {
+  KIND_RANDOM,
+  KIND_SCALED,
+  KIND_NEAR_SINGULAR,
+  KIND_INTEGER,
+  KIND_SPECIAL,
+  KIND_COUNT
+};
+
+static const char *kind_names[] = {"random", "scaled", "near_singular",
+                                   "integer", "special"};
+
+static unsigned long long rng_state;
+
+static int failures;
+static int checks;
+
+static unsigned long long next_random(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+
+  return rng_state;
+}
+
+static int random_int(int n) { return (int)(next_random() % (unsigned)n); }
+
+static double random_unit(void) {
+  return (double)(next_random() >> 11) / (1ull << 53) * 2.0 - 1.0;
+}
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(matrix_t *A, int kind) {
+  double specials[] = {NAN, INFINITY, -INFINITY, 4.9e-324, -1e-310, 0.0};
+
+  for (int i = 0; i < A->rows; i++) {
+    double scale = kind == KIND_SCALED ? ldexp(1.0, random_int(121) - 60) : 1;
+    for (int j = 0; j < A->columns; j++) {
+      A->matrix[i][j] = kind == KIND_INTEGER ? random_int(19) - 9
+                                             : scale * random_unit();
+    }
+  }
+
+  if (kind == KIND_NEAR_SINGULAR && A->rows > 1) {
+    double eps = ldexp(1.0, -random_int(50) - 4);
+    int last = A->rows - 1;
+    for (int j = 0; j < A->columns; j++) {
+      A->matrix[last][j] = A->matrix[0][j] - 0.5 * A->matrix[last - 1][j] +
+                           eps * random_unit();
+    }
+  }
+
+  if (kind == KIND_INTEGER && A->rows > 1 && random_int(4) == 0) {
+    memcpy(A->matrix[A->rows - 1], A->matrix[0], A->columns * sizeof(double));
+  }
+
+  if (kind == KIND_SPECIAL) {
+    for (int s = random_int(3); s >= 0; s--) {
+      A->matrix[random_int(A->rows)][random_int(A->columns)] =
+          specials[random_int(6)];
+    }
+  }
+}
+
+static int all_finite(matrix_t *A) {
+  int finite = 1;
+
+  for (int i = 0; i < A->rows && finite; i++) {
+    for (int j = 0; j < A->columns && finite; j++) {
+      finite = isfinite(A->matrix[i][j]);
+    }
+  }
+
+  return finite;
+}
+
+// reference kernels, kept as simple as the first version of the library
+
+static void ref_minor(matrix_t *A, int row, int column, matrix_t *result) {
+  s21_create_matrix(A->rows - 1, A->columns - 1, result);
+  for (int i = 0, r = 0; i < A->rows; i++) {
+    if (i == row) {
+      continue;
+    }
+    for (int j = 0, c = 0; j < A->columns; j++) {
+      if (j != column) {
+        result->matrix[r][c++] = A->matrix[i][j];
+      }
+    }
+    r++;
+  }
+}
+
+static double ref_determinant(matrix_t *A) {
+  double det = 0.0;
+
+  if (A->rows == 1) {
+    det = A->matrix[0][0];
+  } else if (A->rows == 2) {
+    det = A->matrix[0][0] * A->matrix[1][1] - A->matrix[0][1] * A->matrix[1][0];
+  } else {
+    for (int k = 0; k < A->columns; k++) {
+      matrix_t minor;
+      ref_minor(A, 0, k, &minor);
+      det += (k % 2 ? -1 : 1) * A->matrix[0][k] * ref_determinant(&minor);
+      s21_remove_matrix(&minor);
+    }
+  }
+
+  return det;
+}
+
+static void ref_complements(matrix_t *A, matrix_t *result) {
+  s21_create_matrix(A->rows, A->columns, result);
+  for (int i = 0; i < A->rows; i++) {
+    for (int j = 0; j < A->columns; j++) {
+      matrix_t minor;
+      if (A->rows == 1) {
+        result->matrix[i][j] = 1.0;
+        continue;
+      }
+      ref_minor(A, i, j, &minor);
+      result->matrix[i][j] = ((i + j) % 2 ? -1 : 1) * ref_determinant(&minor);
+      s21_remove_matrix(&minor);
+    }
+  }
+}
+
+// adjugate over determinant, returns the determinant
+static double ref_inverse(matrix_t *A, matrix_t *result) {
+  matrix_t complements;
+  double det = ref_determinant(A);
+
+  ref_complements(A, &complements);
+  s21_create_matrix(A->rows, A->columns, result);
+  for (int i = 0; i < A->rows; i++) {
+    for (int j = 0; j < A->columns; j++) {
+      result->matrix[i][j] = complements.matrix[j][i] / det;
+    }
+  }
+  s21_remove_matrix(&complements);
+
+  return det;
+}
+
+// C = A * B and the error scale |A| * |B|
+static void ref_mult(matrix_t *A, matrix_t *B, matrix_t *C, matrix_t *scale) {
+  s21_create_matrix(A->rows, B->columns, C);
+  if (scale != NULL) {
+    s21_create_matrix(A->rows, B->columns, scale);
+  }
+  for (int i = 0; i < A->rows; i++) {
+    for (int j = 0; j < B->columns; j++) {
+      double sum = 0.0, abs_sum = 0.0;
+      for (int k = 0; k < A->columns; k++) {
+        sum += A->matrix[i][k] * B->matrix[k][j];
+        abs_sum += fabs(A->matrix[i][k] * B->matrix[k][j]);
+      }
+      C->matrix[i][j] = sum;
+      if (scale != NULL) {
+        scale->matrix[i][j] = abs_sum;
+      }
+    }
+  }
+}
+
+// unpivoted cofactor expansion is hopeless for large n, there the reference
+// is plain partial-pivot elimination without blocking or threads
+static double ref_lu_determinant(matrix_t *A) {
+  int n = A->rows;
+  double det = 1.0, *a = malloc((size_t)n * n * sizeof(double));
+
+  memcpy(a, A->matrix[0], (size_t)n * n * sizeof(double));
+  for (int k = 0; k < n && det != 0.0; k++) {
+    int p = k;
+    for (int i = k + 1; i < n; i++) {
+      if (fabs(a[i * n + k]) > fabs(a[p * n + k])) {
+        p = i;
+      }
+    }
+    if (p != k) {
+      for (int j = 0; j < n; j++) {
+        double t = a[k * n + j];
+        a[k * n + j] = a[p * n + j];
+        a[p * n + j] = t;
+      }
+      det = -det;
+    }
+    det *= a[k * n + k];
+    for (int i = k + 1; i < n && a[k * n + k] != 0.0; i++) {
+      double l = a[i * n + k] / a[k * n + k];
+      for (int j = k + 1; j < n; j++) {
+        a[i * n + j] -= l * a[k * n + j];
+      }
+    }
+  }
+  free(a);
+
+  return det;
+}
+
+// the matching inverse: partial-pivot gauss-jordan on [A | I], row by row
+static void ref_lu_inverse(matrix_t *A, matrix_t *result) {
+  int n = A->rows, w = 2 * n;
+  double *a = calloc((size_t)n * w, sizeof(double));
+
+  for (int i = 0; i < n; i++) {
+    memcpy(a + i * w, A->matrix[i], n * sizeof(double));
+    a[i * w + n + i] = 1.0;
+  }
+  for (int k = 0; k < n; k++) {
+    int p = k;
+    for (int i = k + 1; i < n; i++) {
+      if (fabs(a[i * w + k]) > fabs(a[p * w + k])) {
+        p = i;
+      }
+    }
+    for (int j = 0; j < w && p != k; j++) {
+      double t = a[k * w + j];
+      a[k * w + j] = a[p * w + j];
+      a[p * w + j] = t;
+    }
+    for (int j = w - 1; j >= k; j--) {
+      a[k * w + j] /= a[k * w + k];
+    }
+    for (int i = 0; i < n; i++) {
+      double l = a[i * w + k];
+      for (int j = k; j < w && i != k; j++) {
+        a[i * w + j] -= l * a[k * w + j];
+      }
+    }
+  }
+  s21_create_matrix(n, n, result);
+  for (int i = 0; i < n; i++) {
+    memcpy(result->matrix[i], a + i * w + n, n * sizeof(double));
+  }
+  free(a);
+}
+
+static double norm_one(matrix_t *A) {
+  double max = 0.0;
+
+  for (int j = 0; j < A->columns; j++) {
+    double sum = 0.0;
+    for (int i = 0; i < A->rows; i++) {
+      sum += fabs(A->matrix[i][j]);
+    }
+    max = fmax(max, sum);
+  }
+
+  return max;
+}
+
+// product of row 1-norms, skipping one row; bounds the cofactor expansion
+// terms so it scales the determinant tolerance
+static double row_norm_product(matrix_t *A, int skip) {
+  double product = 1.0;
+
+  for (int i = 0; i < A->rows; i++) {
+    if (i != skip) {
+      double sum = 0.0;
+      for (int j = 0; j < A->columns; j++) {
+        sum += fabs(A->matrix[i][j]);
+      }
+      product *= sum;
+    }
+  }
+
+  return product;
+}
+
+static void report(const char *op, int kind, int rows, int columns,
+                   const char *what, double got, double want) {
+  failures++;
+  printf("FAIL %s kind=%s %dx%d %s: got %.17g want %.17g\n", op,
+         kind_names[kind], rows, columns, what, got, want);
+}
+
+static int close_to(double got, double want, double tol) {
+  int ok;
+
+  if (!isfinite(want)) {
+    ok = !isfinite(got);
+  } else {
+    ok = isfinite(got) && fabs(got - want) <= tol;
+  }
+
+  return ok;
+}
+
+// bitwise up to nan payloads
+static int same(double a, double b) {
+  return (isnan(a) && isnan(b)) || a == b;
+}
+
+static void check_elementwise(s21_context_t *ctx, int kind) {
+  matrix_t A, B, C;
+  int rows = 1 + random_int(80), columns = 1 + random_int(80);
+  double number = random_unit() * 4;
+
+  s21_create_matrix(rows, columns, &A);
+  s21_create_matrix(rows, columns, &B);
+  fill(&A, kind);
+  fill(&B, kind);
+
+  checks++;
+  s21_sum_matrix_ctx(ctx, &A, &B, &C);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      if (!same(C.matrix[i][j], A.matrix[i][j] + B.matrix[i][j])) {
+        report("sum", kind, rows, columns, "entry", C.matrix[i][j],
+               A.matrix[i][j] + B.matrix[i][j]);
+      }
+    }
+  }
+  s21_remove_matrix_ctx(ctx, &C);
+
+  s21_mult_number_ctx(ctx, &A, number, &C);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      if (!same(C.matrix[i][j], A.matrix[i][j] * number)) {
+        report("mult_number", kind, rows, columns, "entry", C.matrix[i][j],
+               A.matrix[i][j] * number);
+      }
+    }
+  }
+  s21_remove_matrix_ctx(ctx, &C);
+
+  s21_transpose_ctx(ctx, &A, &C);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < columns; j++) {
+      if (!same(C.matrix[j][i], A.matrix[i][j])) {
+        report("transpose", kind, rows, columns, "entry", C.matrix[j][i],
+               A.matrix[i][j]);
+      }
+    }
+  }
+  s21_remove_matrix_ctx(ctx, &C);
+
+  s21_remove_matrix(&A);
+  s21_remove_matrix(&B);
+}
+
+static void check_mult(s21_context_t *ctx, int kind) {
+  matrix_t A, B, C, ref, scale;
+  int m = 1 + random_int(70), k = 1 + random_int(random_int(8) ? 70 : 3000),
+      n = 1 + random_int(70);
+  int err;
+
+  s21_create_matrix(m, k, &A);
+  s21_create_matrix(k, n, &B);
+  fill(&A, kind);
+  fill(&B, kind);
+  ref_mult(&A, &B, &ref, &scale);
+
+  checks++;
+  err = s21_mult_matrix_ctx(ctx, &A, &B, &C);
+  if (err != OK) {
+    report("mult_matrix", kind, m, k, "error", err, OK);
+  } else {
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        double tol =
+            4.0 * (k + 2) * DBL_EPSILON * scale.matrix[i][j] + k * 5e-324;
+        if (!close_to(C.matrix[i][j], ref.matrix[i][j], tol)) {
+          report("mult_matrix", kind, m, k, "entry", C.matrix[i][j],
+                 ref.matrix[i][j]);
+          i = m;
+          break;
+        }
+      }
+    }
+    s21_remove_matrix_ctx(ctx, &C);
+  }
+
+  s21_remove_matrix(&A);
+  s21_remove_matrix(&B);
+  s21_remove_matrix(&ref);
+  s21_remove_matrix(&scale);
+}
+
+static void check_square_small(s21_context_t *ctx, int kind) {
+  matrix_t A, C, ref;
+  int n = 1 + random_int(MAX_SMALL), err;
+  double det, ref_det, tol, cond;
+
+  s21_create_matrix(n, n, &A);
+  fill(&A, kind);
+
+  checks++;
+  ref_det = ref_determinant(&A);
+  tol = 16.0 * n * DBL_EPSILON * row_norm_product(&A, -1) + n * DBL_MIN;
+  err = s21_determinant_ctx(ctx, &A, &det);
+  if (!all_finite(&A)) {
+    if (err != NONFINITE) {
+      report("determinant", kind, n, n, "non-finite input", err, NONFINITE);
+    }
+  } else if (err != OK) {
+    report("determinant", kind, n, n, "error", err, OK);
+  } else if (isfinite(tol) && !close_to(det, ref_det, tol)) {
+    report("determinant", kind, n, n, "value", det, ref_det);
+  }
+
+  err = s21_calc_complements_ctx(ctx, &A, &C);
+  ref_complements(&A, &ref);
+  if (!all_finite(&A)) {
+    if (err != NONFINITE) {
+      report("calc_complements", kind, n, n, "non-finite input", err,
+             NONFINITE);
+    }
+  } else if (err != OK) {
+    report("calc_complements", kind, n, n, "error", err, OK);
+  } else {
+    for (int i = 0; i < n; i++) {
+      double row_tol =
+          16.0 * n * DBL_EPSILON * row_norm_product(&A, i) + n * DBL_MIN;
+      for (int j = 0; j < n && isfinite(row_tol); j++) {
+        if (!close_to(C.matrix[i][j], ref.matrix[i][j], row_tol)) {
+          report("calc_complements", kind, n, n, "entry", C.matrix[i][j],
+                 ref.matrix[i][j]);
+          i = n;
+          break;
+        }
+      }
+    }
+    s21_remove_matrix_ctx(ctx, &C);
+  }
+  s21_remove_matrix(&ref);
+
+  // exactly singular must fail, ill-conditioned may
+  ref_inverse(&A, &ref);
+  cond = norm_one(&A) * norm_one(&ref);
+  err = s21_inverse_matrix_ctx(ctx, &A, &C);
+  if (!all_finite(&A)) {
+    if (err != NONFINITE) {
+      report("inverse_matrix", kind, n, n, "non-finite input", err,
+             NONFINITE);
+    }
+  } else if (ref_det == 0.0 && kind == KIND_INTEGER) {
+    if (err != CALCERR) {
+      report("inverse_matrix", kind, n, n, "singular", err, CALCERR);
+    }
+  } else if (ref_det == 0.0 || !all_finite(&ref)) {
+    // singular to rounding, either answer is fine
+  } else if (err == OK && cond < 1e10) {
+    double max = 0.0;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        max = fmax(max, fabs(ref.matrix[i][j]));
+      }
+    }
+    tol = 64.0 * n * DBL_EPSILON * cond * max;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        if (!close_to(C.matrix[i][j], ref.matrix[i][j], tol)) {
+          report("inverse_matrix", kind, n, n, "entry", C.matrix[i][j],
+                 ref.matrix[i][j]);
+          i = n;
+          break;
+        }
+      }
+    }
+  } else if (err != OK && cond < 1e10) {
+    report("inverse_matrix", kind, n, n, "error", err, OK);
+  }
+  if (err == OK) {
+    s21_remove_matrix_ctx(ctx, &C);
+  }
+  s21_remove_matrix(&ref);
+
+  s21_remove_matrix(&A);
+}
+
+// blocked and threaded lu only kicks in at large n, checked through the
+// unblocked determinant and the residual of A * inverse
+static void check_square_large(s21_context_t *ctx, int kind) {
+  matrix_t A, C, product;
+  int n = LARGE_MIN + random_int(LARGE_SPAN), err;
+  double det, ref_det, residual = 0.0, cond;
+
+  kind = kind == KIND_SPECIAL || kind == KIND_INTEGER ? KIND_RANDOM : kind;
+  s21_create_matrix(n, n, &A);
+  fill(&A, kind);
+  for (int i = 0; i < n; i++) {
+    A.matrix[i][i] += kind == KIND_NEAR_SINGULAR ? 0.0 : 4.0;
+  }
+
+  checks++;
+  ref_det = ref_lu_determinant(&A);
+  err = s21_determinant_ctx(ctx, &A, &det);
+  if (err == NONFINITE && !isfinite(ref_det)) {
+    // both overflowed
+  } else if (err != OK) {
+    report("determinant", kind, n, n, "error", err, OK);
+  } else if (kind != KIND_NEAR_SINGULAR && isfinite(ref_det) &&
+             ref_det != 0.0 && !close_to(det / ref_det, 1.0, 1e-6)) {
+    report("determinant", kind, n, n, "ratio", det / ref_det, 1.0);
+  }
+
+  err = s21_inverse_matrix_ctx(ctx, &A, &C);
+  if (err == OK) {
+    ref_mult(&A, &C, &product, NULL);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        residual = fmax(residual, fabs(product.matrix[i][j] - (i == j)));
+      }
+    }
+    cond = norm_one(&A) * norm_one(&C);
+    if (!(residual <= 64.0 * n * DBL_EPSILON * cond)) {
+      report("inverse_matrix", kind, n, n, "residual", residual,
+             64.0 * n * DBL_EPSILON * cond);
+    }
+    s21_remove_matrix(&product);
+    s21_remove_matrix_ctx(ctx, &C);
+  } else if (kind == KIND_RANDOM) {
+    // scaled rows are ill-conditioned in the 1-norm and may be rejected
+    report("inverse_matrix", kind, n, n, "error", err, OK);
+  }
+
+  s21_remove_matrix(&A);
+}
+
+#define PERF_SIZE 512
+#define PERF_BATCH 0.1
+
+static void run_once(s21_context_t *ctx, int op, matrix_t *A, int ref) {
+  matrix_t C;
+  double det;
+
+  if (op == 0) {
+    if (ref) {
+      ref_mult(A, A, &C, NULL);
+    } else {
+      s21_mult_matrix_ctx(ctx, A, A, &C);
+    }
+  } else if (op == 1) {
+    det = ref ? ref_lu_determinant(A) : 0.0;
+    if (!ref) {
+      s21_determinant_ctx(ctx, A, &det);
+    }
+    (void)det;
+  } else if (ref) {
+    ref_lu_inverse(A, &C);
+  } else {
+    s21_inverse_matrix_ctx(ctx, A, &C);
+  }
+  if (op != 1) {
+    s21_remove_matrix(&C);
+  }
+}
+
+// a batch repeats the call until it has run PERF_BATCH seconds, the time
+// per call is the best batch mean out of three after one warm-up call
+static double best_time(s21_context_t *ctx, int op, matrix_t *A, int ref) {
+  double best = INFINITY;
+
+  run_once(ctx, op, A, ref);
+  for (int batch = 0; batch < 3; batch++) {
+    double start = now(), elapsed;
+    int runs = 0;
+    do {
+      run_once(ctx, op, A, ref);
+      runs++;
+      elapsed = now() - start;
+    } while (elapsed < PERF_BATCH);
+    best = fmin(best, elapsed / runs);
+  }
+
+  return best;
+}
+
+// n=512 fills a 2 MiB l2 where blocking starts to pay; the default floors
+// are the speedups measured on one core with margin, every one of them above
+// 1 so an optimized kernel that loses to the simple one fails the run
+static void check_performance(const double *min_speedup) {
+  const char *names[] = {"mult_matrix", "determinant", "inverse_matrix"};
+  s21_context_t *ctx;
+  matrix_t A;
+
+  s21_context_create(&ctx);
+  s21_create_matrix(PERF_SIZE, PERF_SIZE, &A);
+  fill(&A, KIND_RANDOM);
+  for (int op = 0; op < 3; op++) {
+    double ref = best_time(ctx, op, &A, 1);
+    double fast = best_time(ctx, op, &A, 0);
+    printf("perf %s n=%d reference=%.6fs optimized=%.6fs speedup=%.1f "
+           "(min %.1f)\n",
+           names[op], PERF_SIZE, ref, fast, ref / fast, min_speedup[op]);
+    if (ref / fast < min_speedup[op]) {
+      failures++;
+      printf("FAIL perf %s below the configured speedup\n", names[op]);
+    }
+  }
+  s21_remove_matrix(&A);
+  s21_context_destroy(ctx);
+}
+
+// usage: fuzz_s21_matrix [iterations] [seed] [min speedup of mult det inverse]
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+  int blas = strcmp(s21_backend(), "blas") == 0;
+  double min_speedup[] = {blas ? 30.0 : 4.0, blas ? 2.0 : 1.5,
+                          blas ? 3.0 : 2.0};
+  s21_context_t *ctx;
+
+  rng_state = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+  rng_state = rng_state ? rng_state : 1;
+  for (int i = 0; i < 3 && argc > 3 + i; i++) {
+    min_speedup[i] = atof(argv[3 + i]);
+  }
+
+  s21_async_init(0);
+  s21_context_create(&ctx);
+
+  for (int it = 0; it < iterations; it++) {
+    int kind = random_int(KIND_COUNT);
+    s21_context_set_accumulation(ctx, random_int(ACCUM_DOT2 + 1));
+    s21_context_set_threads(ctx, random_int(5));
+    check_elementwise(ctx, kind);
+    check_mult(ctx, kind);
+    check_square_small(ctx, kind);
+    if (it % 16 == 0) {
+      check_square_large(ctx, kind);
+    }
+  }
+  printf("fuzz backend=%s iterations=%d checks=%d failures=%d\n",
+         s21_backend(), iterations, checks, failures);
+
+  check_performance(min_speedup);
+
+  s21_context_destroy(ctx);
+  s21_async_shutdown();
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "s21_internal.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// blocks below one huge page come from malloc, larger ones are mapped in
+// whole huge pages aligned to their size
+#define HUGE_PAGE ((size_t)2 << 20)
+
+typedef struct touch_args {
+  double *data;
+  int rows;
+  int columns;
+} touch_args_t;
+
+static size_t huge_round(size_t size) {
+  return (size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+}
+
+// over-map by one huge page and trim both ends, so the kernel can back the
+// range with transparent huge pages from the first byte
+static void *map_aligned(size_t size) {
+  char *raw, *aligned;
+  size_t head;
+
+  raw = mmap(NULL, size + HUGE_PAGE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return NULL;
+  }
+
+  aligned = (char *)(((uintptr_t)raw + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1));
+  head = aligned - raw;
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  munmap(aligned + size, HUGE_PAGE - head);
+
+#ifdef MADV_HUGEPAGE
+  madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+  return aligned;
+}
+
+// explicit huge pages when the system reserved some, transparent ones
+// otherwise
+static void *huge_alloc(size_t size, void *user) {
+  void *ptr = NULL;
+
+  (void)user;
+
+  if (size < HUGE_PAGE) {
+    return malloc(size);
+  }
+
+  size = huge_round(size);
+#ifdef MAP_HUGETLB
+  ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  ptr = ptr == MAP_FAILED ? NULL : ptr;
+#endif
+  if (ptr == NULL) {
+    ptr = map_aligned(size);
+  }
+
+  return ptr;
+}
+
+static void huge_release(void *ptr, size_t size, void *user) {
+  (void)user;
+
+  if (size < HUGE_PAGE) {
+    free(ptr);
+  } else {
+    munmap(ptr, huge_round(size));
+  }
+}
+
+s21_allocator_t s21_hugepage_allocator(void) {
+  s21_allocator_t allocator = {huge_alloc, huge_release, NULL};
+
+  return allocator;
+}
+
+static void touch_band(void *arg, int band, int r0, int r1) {
+  const touch_args_t *t = arg;
+
+  (void)band;
+  memset(t->data + (size_t)r0 * t->columns, 0,
+         (size_t)(r1 - r0) * t->columns * sizeof(double));
+}
+
+// each band of rows is first written by the worker that is offered it again
+// in the kernels, which places its pages on that node; below a huge page the
+// data shares pages with other blocks anyway
+void s21_first_touch(double *data, int rows, int columns, int threads) {
+  touch_args_t t = {data, rows, columns};
+
+  if ((size_t)rows * columns * sizeof(double) >= HUGE_PAGE) {
+    s21_parallel_bands(threads, data, rows, columns, touch_band, &t);
+  }
+}
+
+// an even split moved to the first row that starts on or after the nearest
+// page boundary, so two bands share at most the tail of one row's page
+int s21_band_start(const double *data, int rows, int ld, int bands, int band) {
+  size_t row_bytes = (size_t)ld * sizeof(double);
+  size_t total = (size_t)rows * row_bytes;
+  int start = (int)((long long)rows * band / bands);
+
+  if (band > 0 && band < bands && total / bands >= HUGE_PAGE) {
+    uintptr_t base = (uintptr_t)data;
+    uintptr_t edge = base + total / bands * band;
+    edge = (edge + HUGE_PAGE / 2) & ~(uintptr_t)(HUGE_PAGE - 1);
+    start = (int)((edge - base + row_bytes - 1) / row_bytes);
+    start = start < rows ? start : rows;
+  }
+
+  return start;
+}
@@ -0,0 +1,343 @@
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "s21_internal.h"
+
+enum async_ops {
+  OP_SUM,
+  OP_SUB,
+  OP_MULT_NUMBER,
+  OP_MULT_MATRIX,
+  OP_TRANSPOSE,
+  OP_COMPLEMENTS,
+  OP_DETERMINANT,
+  OP_INVERSE
+};
+
+typedef struct dependent {
+  s21_future_t *future;
+  struct dependent *next;
+} dependent_t;
+
+typedef struct callback {
+  s21_callback_t fn;
+  void *user;
+  struct callback *next;
+} callback_t;
+
+// each op runs on its own context, so concurrent ops never share a workspace
+// and the caller's context is free again as soon as the op is submitted
+struct s21_future {
+  s21_context_t ctx;
+  int op;
+  matrix_t *A;
+  matrix_t *B;
+  double number;
+  matrix_t *result;
+  double *det;
+
+  int err;
+  int done;
+  atomic_int refs;
+  atomic_int waiting;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  dependent_t *dependents;
+  callback_t *callbacks;
+};
+
+static void future_run(void *arg);
+
+static void future_complete(s21_future_t *future, int err) {
+  dependent_t *dependents, *dep;
+  callback_t *callbacks, *cb;
+
+  pthread_mutex_lock(&future->lock);
+  future->err = err;
+  future->done = 1;
+  dependents = future->dependents;
+  callbacks = future->callbacks;
+  future->dependents = NULL;
+  future->callbacks = NULL;
+  pthread_cond_broadcast(&future->cond);
+  pthread_mutex_unlock(&future->lock);
+
+  while (callbacks != NULL) {
+    cb = callbacks;
+    callbacks = cb->next;
+    cb->fn(future, cb->user);
+    free(cb);
+  }
+
+  while (dependents != NULL) {
+    dep = dependents;
+    dependents = dep->next;
+    if (err != OK) {
+      pthread_mutex_lock(&dep->future->lock);
+      dep->future->err = err;
+      pthread_mutex_unlock(&dep->future->lock);
+    }
+    if (atomic_fetch_sub(&dep->future->waiting, 1) == 1) {
+      if (s21_pool_submit(future_run, dep->future) != OK) {
+        future_complete(dep->future, WRONGMAT);
+      }
+    }
+    free(dep);
+  }
+
+  s21_future_release(future);
+}
+
+static void future_run(void *arg) {
+  s21_future_t *future = arg;
+  int err = s21_future_error(future);
+
+  if (err != OK) {
+    future_complete(future, err);
+    return;
+  }
+
+  switch (future->op) {
+    case OP_SUM:
+      err = s21_sum_matrix_ctx(&future->ctx, future->A, future->B,
+                               future->result);
+      break;
+    case OP_SUB:
+      err = s21_sub_matrix_ctx(&future->ctx, future->A, future->B,
+                               future->result);
+      break;
+    case OP_MULT_NUMBER:
+      err = s21_mult_number_ctx(&future->ctx, future->A, future->number,
+                                future->result);
+      break;
+    case OP_MULT_MATRIX:
+      err = s21_mult_matrix_ctx(&future->ctx, future->A, future->B,
+                                future->result);
+      break;
+    case OP_TRANSPOSE:
+      err = s21_transpose_ctx(&future->ctx, future->A, future->result);
+      break;
+    case OP_COMPLEMENTS:
+      err = s21_calc_complements_ctx(&future->ctx, future->A, future->result);
+      break;
+    case OP_DETERMINANT:
+      err = s21_determinant_ctx(&future->ctx, future->A, future->det);
+      break;
+    default:
+      err = s21_inverse_matrix_ctx(&future->ctx, future->A, future->result);
+      break;
+  }
+  s21_context_clear(&future->ctx);
+
+  future_complete(future, err);
+}
+
+static s21_future_t *future_submit(s21_future_t *future, s21_future_t **deps,
+                                   int ndeps) {
+  dependent_t *dep;
+  int err = OK;
+
+  if (future == NULL) {
+    return future;
+  }
+
+  // one extra reference keeps the future alive until it completes and the
+  // waiting count holds one guard entry until all deps are registered
+  atomic_init(&future->refs, 2);
+  atomic_init(&future->waiting, 1);
+  future->err = OK;
+  future->done = 0;
+  future->dependents = NULL;
+  future->callbacks = NULL;
+  pthread_mutex_init(&future->lock, NULL);
+  pthread_cond_init(&future->cond, NULL);
+
+  for (int i = 0; i < ndeps; i++) {
+    if (deps[i] == NULL) {
+      continue;
+    }
+    pthread_mutex_lock(&deps[i]->lock);
+    if (deps[i]->done) {
+      if (deps[i]->err != OK) {
+        err = deps[i]->err;
+      }
+    } else if ((dep = malloc(sizeof(dependent_t))) == NULL) {
+      err = WRONGMAT;
+    } else {
+      atomic_fetch_add(&future->waiting, 1);
+      dep->future = future;
+      dep->next = deps[i]->dependents;
+      deps[i]->dependents = dep;
+    }
+    pthread_mutex_unlock(&deps[i]->lock);
+  }
+
+  if (err != OK) {
+    pthread_mutex_lock(&future->lock);
+    future->err = err;
+    pthread_mutex_unlock(&future->lock);
+  }
+
+  if (atomic_fetch_sub(&future->waiting, 1) == 1) {
+    if (s21_pool_submit(future_run, future) != OK) {
+      future_complete(future, WRONGMAT);
+    }
+  }
+
+  return future;
+}
+
+static s21_future_t *future_create(s21_context_t *ctx, int op, matrix_t *A,
+                                   matrix_t *B, matrix_t *result) {
+  s21_future_t *future = calloc(1, sizeof(s21_future_t));
+
+  if (future != NULL) {
+    s21_context_inherit(&future->ctx, ctx);
+    future->op = op;
+    future->A = A;
+    future->B = B;
+    future->result = result;
+  }
+
+  return future;
+}
+
+int s21_async_init(int threads) { return s21_pool_start(threads); }
+
+void s21_async_shutdown(void) { s21_pool_stop(); }
+
+s21_future_t *s21_async_sum_matrix(s21_context_t *ctx, matrix_t *A,
+                                   matrix_t *B, matrix_t *result,
+                                   s21_future_t **deps, int ndeps) {
+  return future_submit(future_create(ctx, OP_SUM, A, B, result), deps, ndeps);
+}
+
+s21_future_t *s21_async_sub_matrix(s21_context_t *ctx, matrix_t *A,
+                                   matrix_t *B, matrix_t *result,
+                                   s21_future_t **deps, int ndeps) {
+  return future_submit(future_create(ctx, OP_SUB, A, B, result), deps, ndeps);
+}
+
+s21_future_t *s21_async_mult_number(s21_context_t *ctx, matrix_t *A,
+                                    double number, matrix_t *result,
+                                    s21_future_t **deps, int ndeps) {
+  s21_future_t *future = future_create(ctx, OP_MULT_NUMBER, A, NULL, result);
+
+  if (future != NULL) {
+    future->number = number;
+  }
+
+  return future_submit(future, deps, ndeps);
+}
+
+s21_future_t *s21_async_mult_matrix(s21_context_t *ctx, matrix_t *A,
+                                    matrix_t *B, matrix_t *result,
+                                    s21_future_t **deps, int ndeps) {
+  return future_submit(future_create(ctx, OP_MULT_MATRIX, A, B, result), deps,
+                       ndeps);
+}
+
+s21_future_t *s21_async_transpose(s21_context_t *ctx, matrix_t *A,
+                                  matrix_t *result, s21_future_t **deps,
+                                  int ndeps) {
+  return future_submit(future_create(ctx, OP_TRANSPOSE, A, NULL, result), deps,
+                       ndeps);
+}
+
+s21_future_t *s21_async_calc_complements(s21_context_t *ctx, matrix_t *A,
+                                         matrix_t *result, s21_future_t **deps,
+                                         int ndeps) {
+  return future_submit(future_create(ctx, OP_COMPLEMENTS, A, NULL, result),
+                       deps, ndeps);
+}
+
+s21_future_t *s21_async_determinant(s21_context_t *ctx, matrix_t *A,
+                                    double *result, s21_future_t **deps,
+                                    int ndeps) {
+  s21_future_t *future = future_create(ctx, OP_DETERMINANT, A, NULL, NULL);
+
+  if (future != NULL) {
+    future->det = result;
+  }
+
+  return future_submit(future, deps, ndeps);
+}
+
+s21_future_t *s21_async_inverse_matrix(s21_context_t *ctx, matrix_t *A,
+                                       matrix_t *result, s21_future_t **deps,
+                                       int ndeps) {
+  return future_submit(future_create(ctx, OP_INVERSE, A, NULL, result), deps,
+                       ndeps);
+}
+
+int s21_future_poll(s21_future_t *future) {
+  int done;
+
+  pthread_mutex_lock(&future->lock);
+  done = future->done;
+  pthread_mutex_unlock(&future->lock);
+
+  return done ? SUCCESS : FAILURE;
+}
+
+int s21_future_wait(s21_future_t *future) {
+  int err;
+
+  // a waiting worker keeps running queued tasks so chained futures progress
+  while (s21_future_poll(future) == FAILURE && s21_pool_help()) {
+  }
+
+  pthread_mutex_lock(&future->lock);
+  while (!future->done) {
+    pthread_cond_wait(&future->cond, &future->lock);
+  }
+  err = future->err;
+  pthread_mutex_unlock(&future->lock);
+
+  return err;
+}
+
+int s21_future_then(s21_future_t *future, s21_callback_t callback,
+                    void *user) {
+  int err = OK, done;
+  callback_t *cb = NULL;
+
+  pthread_mutex_lock(&future->lock);
+  done = future->done;
+  if (!done) {
+    cb = malloc(sizeof(callback_t));
+    if (cb == NULL) {
+      err = WRONGMAT;
+    } else {
+      cb->fn = callback;
+      cb->user = user;
+      cb->next = future->callbacks;
+      future->callbacks = cb;
+    }
+  }
+  pthread_mutex_unlock(&future->lock);
+
+  if (done) {
+    callback(future, user);
+  }
+
+  return err;
+}
+
+int s21_future_error(s21_future_t *future) {
+  int err;
+
+  pthread_mutex_lock(&future->lock);
+  err = future->err;
+  pthread_mutex_unlock(&future->lock);
+
+  return err;
+}
+
+void s21_future_release(s21_future_t *future) {
+  if (future != NULL && atomic_fetch_sub(&future->refs, 1) == 1) {
+    pthread_mutex_destroy(&future->lock);
+    pthread_cond_destroy(&future->cond);
+    free(future);
+  }
+}
@@ -0,0 +1,216 @@
+#include <pthread.h>
+
+#include "s21_internal.h"
+
+static _Thread_local s21_context_t thread_context;
+static _Thread_local int thread_context_ready = 0;
+
+static pthread_key_t thread_context_key;
+static pthread_once_t thread_context_once = PTHREAD_ONCE_INIT;
+
+static void *default_alloc(size_t size, void *user) {
+  (void)user;
+  return malloc(size);
+}
+
+static void default_release(void *ptr, size_t size, void *user) {
+  (void)size;
+  (void)user;
+  free(ptr);
+}
+
+static void context_defaults(s21_context_t *ctx) {
+  ctx->allocator.alloc = default_alloc;
+  ctx->allocator.release = default_release;
+  ctx->allocator.user = NULL;
+  ctx->threads = 0;
+  ctx->workspace = NULL;
+  ctx->workspace_size = 0;
+  ctx->workspace_busy = 0;
+  ctx->accumulation = ACCUM_NAIVE;
+  ctx->flush_denormals = 0;
+  ctx->check_finite = 0;
+  ctx->first_touch = 0;
+}
+
+static void context_release_workspace(s21_context_t *ctx) {
+  if (ctx->workspace != NULL) {
+    ctx->allocator.release(ctx->workspace, ctx->workspace_size,
+                           ctx->allocator.user);
+    ctx->workspace = NULL;
+    ctx->workspace_size = 0;
+  }
+}
+
+static void thread_context_cleanup(void *ctx) {
+  context_release_workspace(ctx);
+}
+
+static void thread_context_key_init(void) {
+  pthread_key_create(&thread_context_key, thread_context_cleanup);
+}
+
+int s21_context_create(s21_context_t **result) {
+  int err = OK;
+
+  if (result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  *result = malloc(sizeof(s21_context_t));
+  if (*result == NULL) {
+    err = WRONGMAT;
+  } else {
+    context_defaults(*result);
+  }
+
+  return err;
+}
+
+void s21_context_destroy(s21_context_t *ctx) {
+  if (ctx != NULL) {
+    context_release_workspace(ctx);
+    free(ctx);
+  }
+}
+
+void s21_context_inherit(s21_context_t *ctx, s21_context_t *from) {
+  if (from != NULL) {
+    *ctx = *from;
+    ctx->workspace = NULL;
+    ctx->workspace_size = 0;
+    ctx->workspace_busy = 0;
+  } else {
+    context_defaults(ctx);
+  }
+}
+
+void s21_context_clear(s21_context_t *ctx) { context_release_workspace(ctx); }
+
+int s21_context_reserve(s21_context_t *ctx, size_t size) {
+  int err = OK;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (size > ctx->workspace_size && ctx->workspace_busy) {
+    err = WRONGMAT;
+  } else if (size > ctx->workspace_size) {
+    context_release_workspace(ctx);
+    ctx->workspace = ctx->allocator.alloc(size, ctx->allocator.user);
+    if (ctx->workspace == NULL) {
+      err = WRONGMAT;
+    } else {
+      ctx->workspace_size = size;
+    }
+  }
+
+  return err;
+}
+
+int s21_context_set_allocator(s21_context_t *ctx, s21_allocator_t allocator) {
+  int err = OK;
+
+  if (ctx == NULL || allocator.alloc == NULL || allocator.release == NULL ||
+      ctx->workspace_busy) {
+    err = WRONGMAT;
+  } else {
+    context_release_workspace(ctx);
+    ctx->allocator = allocator;
+  }
+
+  return err;
+}
+
+int s21_context_set_threads(s21_context_t *ctx, int threads) {
+  int err = OK;
+
+  if (ctx == NULL || threads < 0) {
+    err = WRONGMAT;
+  } else {
+    ctx->threads = threads;
+  }
+
+  return err;
+}
+
+int s21_context_set_accumulation(s21_context_t *ctx, int mode) {
+  int err = OK;
+
+  if (ctx == NULL || mode < ACCUM_NAIVE || mode > ACCUM_DOT2) {
+    err = WRONGMAT;
+  } else {
+    ctx->accumulation = mode;
+  }
+
+  return err;
+}
+
+int s21_context_set_flush_denormals(s21_context_t *ctx, int enable) {
+  int err = OK;
+
+  if (ctx == NULL) {
+    err = WRONGMAT;
+  } else {
+    ctx->flush_denormals = enable != 0;
+  }
+
+  return err;
+}
+
+int s21_context_set_check_finite(s21_context_t *ctx, int enable) {
+  int err = OK;
+
+  if (ctx == NULL) {
+    err = WRONGMAT;
+  } else {
+    ctx->check_finite = enable != 0;
+  }
+
+  return err;
+}
+
+int s21_context_set_first_touch(s21_context_t *ctx, int enable) {
+  int err = OK;
+
+  if (ctx == NULL) {
+    err = WRONGMAT;
+  } else {
+    ctx->first_touch = enable != 0;
+  }
+
+  return err;
+}
+
+s21_context_t *s21_resolve_context(s21_context_t *ctx) {
+  if (ctx == NULL) {
+    if (!thread_context_ready) {
+      context_defaults(&thread_context);
+      pthread_once(&thread_context_once, thread_context_key_init);
+      pthread_setspecific(thread_context_key, &thread_context);
+      thread_context_ready = 1;
+    }
+    ctx = &thread_context;
+  }
+
+  return ctx;
+}
+
+void *s21_workspace(s21_context_t *ctx, size_t size) {
+  void *ws = NULL;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (!ctx->workspace_busy && s21_context_reserve(ctx, size) == OK) {
+    ws = ctx->workspace;
+    ctx->workspace_busy = ws != NULL;
+  }
+
+  return ws;
+}
+
+void s21_workspace_release(s21_context_t *ctx, void *ws) {
+  if (ws != NULL) {
+    s21_resolve_context(ctx)->workspace_busy = 0;
+  }
+}
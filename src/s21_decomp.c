@@ -0,0 +1,963 @@
+#include <float.h>
+
+#include "s21_internal.h"
+
+// upper bounds before a decomposition reports that it did not converge
+#define EIGEN_MAX_ITERATIONS 30
+#define SVD_MAX_SWEEPS 60
+
+// reflectors per block of the tridiagonal and qr reductions, rows per jacobi
+// block, and the column width in which ql rotations reach the vectors
+#define REFLECTOR_BLOCK 32
+#define SVD_BLOCK 16
+#define ROTATION_BLOCK 64
+
+// scratch of apply_block for w reflectors of length len on nc columns
+#define BLOCK_WORK(w, len, nc)                                        \
+  ((size_t)(w) * (w) + (size_t)(len) * (w) + 2 * (size_t)(w) * (nc) + \
+   (size_t)(len) * (nc))
+
+static void swap_rows(double *a, double *b, int count) {
+  double tmp;
+
+  for (int j = 0; j < count; j++) {
+    tmp = a[j];
+    a[j] = b[j];
+    b[j] = tmp;
+  }
+}
+
+static double dot(const double *a, const double *b, int count) {
+  double sum = 0.0;
+
+  for (int i = 0; i < count; i++) {
+    sum += a[i] * b[i];
+  }
+
+  return sum;
+}
+
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+// T of the compact wy form H_0 ... H_{w-1} = I - V T V^T, upper triangular,
+// for reflectors H_j = I - tau_j v_j v_j^T given as the rows of vt (lapack
+// dlarft, forward and columnwise)
+static void block_factor(const double *vt, int w, int len, const double *tau,
+                         double *t) {
+  double sum;
+
+  for (int j = 0; j < w; j++) {
+    for (int p = 0; p < w; p++) {
+      t[j * w + p] = 0.0;
+    }
+  }
+
+  for (int j = 0; j < w; j++) {
+    for (int p = 0; p < j; p++) {
+      t[p * w + j] = -tau[j] * dot(vt + p * len, vt + j * len, len);
+    }
+    for (int p = 0; p < j; p++) {
+      sum = 0.0;
+      for (int k = p; k < j; k++) {
+        sum += t[p * w + k] * t[k * w + j];
+      }
+      t[p * w + j] = sum;
+    }
+    t[j * w + j] = tau[j];
+  }
+}
+
+// c = (I - V T V^T) c, or with T^T when trans, for the len x nc block c in
+// three gemm calls: Y = V^T c, Z = T Y and c -= V Z
+static void apply_block(const double *vt, const double *t, int w, int len,
+                        int trans, double *c, int ldc, int nc, double *work,
+                        int threads) {
+  double *tm = work, *v = tm + w * w, *y = v + len * w, *z = y + w * nc;
+  double *u = z + w * nc;
+
+  if (w == 0 || len == 0 || nc == 0) {
+    return;
+  }
+
+  for (int i = 0; i < w; i++) {
+    for (int j = 0; j < w; j++) {
+      tm[i * w + j] = trans ? t[j * w + i] : t[i * w + j];
+    }
+  }
+  for (int i = 0; i < len; i++) {
+    for (int p = 0; p < w; p++) {
+      v[i * w + p] = vt[p * len + i];
+    }
+  }
+
+  s21_gemm(w, nc, len, vt, len, c, ldc, y, nc, threads);
+  s21_gemm(w, nc, w, tm, w, y, nc, z, nc, threads);
+  s21_gemm(len, nc, w, v, w, z, nc, u, nc, threads);
+
+  for (int i = 0; i < len; i++) {
+    for (int j = 0; j < nc; j++) {
+      c[i * ldc + j] -= u[i * nc + j];
+    }
+  }
+}
+
+// scratch of tridiagonalize and tridiagonal_q past the matrices themselves
+static size_t tridiagonal_work(int n) {
+  int w = min_int(REFLECTOR_BLOCK, n);
+
+  return 5 * (size_t)w * n + (size_t)n * n + (size_t)w * w +
+         BLOCK_WORK(w, n, n);
+}
+
+// householder reduction of the symmetric a (both triangles stored) to the
+// tridiagonal (d, e), e[i] coupling i and i + 1, blocked as lapack dsytrd: a
+// panel of reflectors is built against the deferred update A - V W^T - W V^T
+// (dlatrd) and the trailing matrix takes that update in one gemm; row i of a
+// keeps reflector i, its unit at column i + 1
+static void tridiagonalize(double *a, int n, double *d, double *e,
+                           double *tau, double *work, int threads) {
+  int w, len, rest;
+  double *wt = work, *pm, *rm, *tmp, *row, *wr, *v;
+  double xnorm, alpha, beta, sv, sw;
+
+  for (int k = 0; k < n; k += REFLECTOR_BLOCK) {
+    w = min_int(REFLECTOR_BLOCK, n - k);
+
+    for (int j = 0; j < w; j++) {
+      int i = k + j;
+      row = a + i * n;
+      wr = wt + j * n;
+      len = n - i - 1;
+
+      // row i as the earlier reflectors of the panel left it
+      for (int p = 0; p < j; p++) {
+        const double *vp = a + (k + p) * n, *wp = wt + p * n;
+        double vi = vp[i], wi = wp[i];
+        for (int c = i; c < n; c++) {
+          row[c] -= vi * wp[c] + wi * vp[c];
+        }
+      }
+
+      d[i] = row[i];
+      e[i] = len > 0 ? row[i + 1] : 0.0;
+      tau[i] = 0.0;
+
+      if (len > 1) {
+        xnorm = sqrt(dot(row + i + 2, row + i + 2, len - 1));
+        if (xnorm != 0.0) {
+          alpha = row[i + 1];
+          beta = alpha > 0 ? -hypot(alpha, xnorm) : hypot(alpha, xnorm);
+          tau[i] = (beta - alpha) / beta;
+          for (int c = i + 2; c < n; c++) {
+            row[c] /= alpha - beta;
+          }
+          e[i] = beta;
+        }
+      }
+      if (len > 0) {
+        row[i + 1] = 1.0;
+      }
+
+      // w = tau (A v - V W^T v - W V^T v) - tau / 2 (w^T v) v
+      v = row + i + 1;
+      for (int r = i + 1; r < n; r++) {
+        wr[r] = tau[i] != 0.0 ? dot(a + r * n + i + 1, v, len) : 0.0;
+      }
+      for (int p = 0; p < j && tau[i] != 0.0; p++) {
+        const double *vp = a + (k + p) * n, *wp = wt + p * n;
+        sw = dot(wp + i + 1, v, len);
+        sv = dot(vp + i + 1, v, len);
+        for (int r = i + 1; r < n; r++) {
+          wr[r] -= vp[r] * sw + wp[r] * sv;
+        }
+      }
+      if (tau[i] != 0.0) {
+        for (int r = i + 1; r < n; r++) {
+          wr[r] *= tau[i];
+        }
+        alpha = -0.5 * tau[i] * dot(wr + i + 1, v, len);
+        for (int r = i + 1; r < n; r++) {
+          wr[r] += alpha * v[r - i - 1];
+        }
+      }
+    }
+
+    // trailing A -= [V W] [W V]^T, one gemm, mirrored from the lower half
+    rest = n - k - w;
+    if (rest > 0) {
+      pm = wt + w * n;
+      rm = pm + 2 * (size_t)w * rest;
+      tmp = rm + 2 * (size_t)w * rest;
+      for (int p = 0; p < w; p++) {
+        const double *vp = a + (k + p) * n + k + w, *wp = wt + p * n + k + w;
+        for (int r = 0; r < rest; r++) {
+          pm[r * 2 * w + p] = vp[r];
+          pm[r * 2 * w + w + p] = wp[r];
+          rm[p * rest + r] = wp[r];
+          rm[(w + p) * rest + r] = vp[r];
+        }
+      }
+      s21_gemm(rest, rest, 2 * w, pm, 2 * w, rm, rest, tmp, rest, threads);
+      for (int r = 0; r < rest; r++) {
+        double *ar = a + (k + w + r) * n + k + w;
+        for (int c = 0; c <= r; c++) {
+          ar[c] -= tmp[r * rest + c];
+          a[(k + w + c) * n + k + w + r] = ar[c];
+        }
+      }
+    }
+  }
+}
+
+// q = H_0 ... H_{n-2} from the reflectors tridiagonalize left in a, applied
+// to the identity a block at a time from the last one
+static void tridiagonal_q(const double *a, int n, const double *tau,
+                          double *q, double *work, int threads) {
+  int count = n - 1, w, len;
+  double *vt = work, *t, *scratch;
+
+  for (int i = 0; i < n * n; i++) {
+    q[i] = 0.0;
+  }
+  for (int i = 0; i < n; i++) {
+    q[i * n + i] = 1.0;
+  }
+
+  for (int k = (count - 1) / REFLECTOR_BLOCK * REFLECTOR_BLOCK;
+       count > 0 && k >= 0; k -= REFLECTOR_BLOCK) {
+    w = min_int(REFLECTOR_BLOCK, count - k);
+    len = n - k - 1;
+    t = vt + (size_t)w * len;
+    scratch = t + w * w;
+    for (int p = 0; p < w; p++) {
+      for (int c = 0; c < len; c++) {
+        int g = k + 1 + c;
+        vt[p * len + c] = g < k + p + 1    ? 0.0
+                          : g == k + p + 1 ? 1.0
+                                           : a[(k + p) * n + g];
+      }
+    }
+    block_factor(vt, w, len, tau + k, t);
+    apply_block(vt, t, w, len, 0, q + (k + 1) * n + k + 1, n, len, scratch,
+                threads);
+  }
+}
+
+// rotations of the ql steps for one eigenvalue reach the rows of vt
+// together, a block of columns at a time, so each block of the rows they
+// touch is read once instead of once per step
+static void apply_rotations(double *vt, int n, const int *rows,
+                            const double *cs, const double *sn, int count) {
+  double h;
+
+  for (int c0 = 0; c0 < n; c0 += ROTATION_BLOCK) {
+    int c1 = min_int(c0 + ROTATION_BLOCK, n);
+    for (int r = 0; r < count; r++) {
+      double *vi = vt + rows[r] * n, *vi1 = vi + n;
+      for (int k = c0; k < c1; k++) {
+        h = vi1[k];
+        vi1[k] = sn[r] * vi[k] + cs[r] * h;
+        vi[k] = cs[r] * vi[k] - sn[r] * h;
+      }
+    }
+  }
+}
+
+// implicit ql on the tridiagonal (d, e) (jama tql2); rows of vt are
+// eigenvectors and are rotated only when vt is given, through rows, cs and
+// sn which hold up to EIGEN_MAX_ITERATIONS * n recorded rotations
+static int tridiagonal_ql(double *d, double *e, int n, double *vt,
+                          int *iterations, int *rows, double *cs,
+                          double *sn) {
+  int err = OK;
+  double f = 0.0, tst1 = 0.0, g, p, r, h, dl1, c, c2, c3, el1, s, s2;
+  int m, iter, count;
+
+  e[n - 1] = 0.0;
+
+  for (int l = 0; l < n && err == OK; l++) {
+    tst1 = fmax(tst1, fabs(d[l]) + fabs(e[l]));
+    m = l;
+    while (m < n - 1 && !(fabs(e[m]) <= DBL_EPSILON * tst1)) {
+      m++;
+    }
+
+    iter = 0;
+    count = 0;
+    while (m > l && !(fabs(e[l]) <= DBL_EPSILON * tst1)) {
+      if (++iter > EIGEN_MAX_ITERATIONS) {
+        err = CALCERR;
+        break;
+      }
+      (*iterations)++;
+
+      g = d[l];
+      p = (d[l + 1] - g) / (2.0 * e[l]);
+      r = p < 0 ? -hypot(p, 1.0) : hypot(p, 1.0);
+      d[l] = e[l] / (p + r);
+      d[l + 1] = e[l] * (p + r);
+      dl1 = d[l + 1];
+      h = g - d[l];
+      for (int i = l + 2; i < n; i++) {
+        d[i] -= h;
+      }
+      f += h;
+
+      p = d[m];
+      c = 1.0;
+      c2 = c;
+      c3 = c;
+      el1 = e[l + 1];
+      s = 0.0;
+      s2 = 0.0;
+      for (int i = m - 1; i >= l; i--) {
+        c3 = c2;
+        c2 = c;
+        s2 = s;
+        g = c * e[i];
+        h = c * p;
+        r = hypot(p, e[i]);
+        e[i + 1] = s * r;
+        s = e[i] / r;
+        c = p / r;
+        p = c * d[i] - s * g;
+        d[i + 1] = h + s * (c * g + s * d[i]);
+
+        rows[count] = i;
+        cs[count] = c;
+        sn[count++] = s;
+      }
+      p = -s * s2 * c3 * el1 * e[l] / dl1;
+      e[l] = s * p;
+      d[l] = c * p;
+    }
+
+    if (vt != NULL) {
+      apply_rotations(vt, n, rows, cs, sn, count);
+    }
+
+    d[l] += f;
+    e[l] = 0.0;
+  }
+
+  return err;
+}
+
+// orders values ascending or descending together with rows of up to two
+// companion arrays of the given row lengths
+static void sort_values(double *values, int n, int descending, double *a,
+                        int la, double *b, int lb) {
+  for (int i = 0; i < n - 1; i++) {
+    int k = i;
+    for (int j = i + 1; j < n; j++) {
+      if (descending ? values[j] > values[k] : values[j] < values[k]) {
+        k = j;
+      }
+    }
+    if (k != i) {
+      swap_rows(values + i, values + k, 1);
+      if (a != NULL) {
+        swap_rows(a + i * la, a + k * la, la);
+      }
+      if (b != NULL) {
+        swap_rows(b + i * lb, b + k * lb, lb);
+      }
+    }
+  }
+}
+
+int s21_eigen_symmetric(matrix_t *A, matrix_t *values, matrix_t *vectors,
+                        int *iterations) {
+  return s21_eigen_symmetric_ctx(NULL, A, values, vectors, iterations);
+}
+
+int s21_eigen_symmetric_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *values,
+                            matrix_t *vectors, int *iterations) {
+  int err = OK;
+  int n, count = 0, *rows;
+  double *a, *vt, *d, *e, *tau, *cs, *sn, *work;
+  size_t rotations;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows != A->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  err = s21_finite_inputs(ctx, A, NULL, 1);
+
+  if (err != OK) {
+    return err;
+  }
+
+  n = A->rows;
+  rotations = (size_t)EIGEN_MAX_ITERATIONS * n;
+  a = s21_workspace(ctx, (2 * (size_t)n * n + 3 * (size_t)n + 2 * rotations +
+                          tridiagonal_work(n)) *
+                                 sizeof(double) +
+                             rotations * sizeof(int));
+
+  if (a == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  vt = a + n * n;
+  d = vt + n * n;
+  e = d + n;
+  tau = e + n;
+  cs = tau + n;
+  sn = cs + rotations;
+  work = sn + rotations;
+  rows = (int *)(work + tridiagonal_work(n));
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      a[i * n + j] = i >= j ? A->matrix[i][j] : A->matrix[j][i];
+    }
+  }
+
+  tridiagonalize(a, n, d, e, tau, work, ctx->threads);
+
+  // rows of vt start as the columns of Q, the ql rotations act on them
+  if (vectors != NULL) {
+    tridiagonal_q(a, n, tau, vt, work, ctx->threads);
+    for (int i = 0; i < n; i++) {
+      for (int j = i + 1; j < n; j++) {
+        swap_rows(vt + i * n + j, vt + j * n + i, 1);
+      }
+    }
+  }
+
+  err = tridiagonal_ql(d, e, n, vectors != NULL ? vt : NULL, &count, rows, cs,
+                       sn);
+
+  if (iterations != NULL) {
+    *iterations = count;
+  }
+
+  if (err == OK) {
+    sort_values(d, n, 0, vectors != NULL ? vt : NULL, n, NULL, 0);
+    err = s21_create_matrix_ctx(ctx, n, 1, values);
+  }
+
+  if (err == OK && vectors != NULL) {
+    err = s21_create_matrix_ctx(ctx, n, n, vectors);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, values);
+    }
+  }
+
+  if (err == OK) {
+    for (int i = 0; i < n; i++) {
+      values->matrix[i][0] = d[i];
+      for (int j = 0; j < n && vectors != NULL; j++) {
+        vectors->matrix[i][j] = vt[j * n + i];
+      }
+    }
+  }
+
+  s21_workspace_release(ctx, a);
+
+  return err;
+}
+
+// scratch of jacobi_svd for q rows of length p
+static size_t jacobi_work(int p, int q) {
+  size_t s = (size_t)min_int(2 * SVD_BLOCK, q);
+
+  return s * (2 * (size_t)p + 2 * (size_t)q + 5 * s);
+}
+
+// rotations recorded for a block pair: the rows they mix and their cosine
+// and sine, with m accumulating their product
+typedef struct jacobi_rotations {
+  int *a;
+  int *b;
+  double *cs;
+  double *sn;
+  double *m;
+  int count;
+} jacobi_rotations_t;
+
+static void rotate(double *x, double *y, int count, double cs, double sn) {
+  double u, v;
+
+  for (int k = 0; k < count; k++) {
+    u = x[k];
+    v = y[k];
+    x[k] = cs * u - sn * v;
+    y[k] = sn * u + cs * v;
+  }
+}
+
+// jacobi rotations on the pairs (a, b) of the gram matrix g of s rows with a
+// in [a0, a1) and b in [b0, b1) above it, recorded in rot; a row whose
+// squared norm is at most tiny has collapsed to rounding noise and is left
+// alone, rotating it against the relative test alone never converges
+static void rotate_pairs(double *g, int s, int a0, int a1, int b0, int b1,
+                         double tiny, jacobi_rotations_t *rot) {
+  double alpha, beta, gamma, zeta, t, cs, sn;
+
+  for (int a = a0; a < a1; a++) {
+    for (int b = a + 1 > b0 ? a + 1 : b0; b < b1; b++) {
+      alpha = g[a * s + a];
+      beta = g[b * s + b];
+      gamma = g[a * s + b];
+
+      if (alpha > tiny && beta > tiny &&
+          fabs(gamma) > DBL_EPSILON * sqrt(alpha * beta)) {
+        zeta = (beta - alpha) / (2.0 * gamma);
+        t = (zeta >= 0 ? 1.0 : -1.0) / (fabs(zeta) + hypot(1.0, zeta));
+        cs = 1.0 / hypot(1.0, t);
+        sn = cs * t;
+        rotate(g + a * s, g + b * s, s, cs, sn);
+        for (int k = 0; k < s; k++) {
+          rotate(g + k * s + a, g + k * s + b, 1, cs, sn);
+        }
+        rotate(rot->m + a * s, rot->m + b * s, s, cs, sn);
+        rot->a[rot->count] = a;
+        rot->b[rot->count] = b;
+        rot->cs[rot->count] = cs;
+        rot->sn[rot->count++] = sn;
+      }
+    }
+  }
+}
+
+// one pass over the rows of blocks bi and bj of c (length p) and vt (length
+// q): the rotations run on their gram matrix, and reach the rows as two gemm
+// calls with the accumulated product when most pairs rotated, one by one
+// otherwise; the rows of a block pair among themselves on its first pass of
+// the sweep, the last block's on the pass that pairs it with the first
+static int jacobi_pair(double *c, int p, double *vt, int q, int bi, int bj,
+                       int last, double tiny, double *work, int threads) {
+  int i0 = bi * SVD_BLOCK, ni = min_int(SVD_BLOCK, q - i0);
+  int j0 = bj * SVD_BLOCK, nj = bi == bj ? 0 : min_int(SVD_BLOCK, q - j0);
+  int s = ni + nj, wide = p > q ? p : q, idx[2 * SVD_BLOCK];
+  double *rows = work, *v = rows + s * p, *out = v + s * q, *g = out + s * wide;
+  jacobi_rotations_t rot = {(int *)(g + 4 * s * s), NULL, g + s * s,
+                            g + 2 * s * s, g + 3 * s * s, 0};
+
+  rot.b = rot.a + s * s;
+  for (int r = 0; r < s; r++) {
+    idx[r] = r < ni ? i0 + r : j0 + r - ni;
+    for (int k = 0; k < s; k++) {
+      rot.m[r * s + k] = r == k;
+    }
+  }
+  for (int a = 0; a < s; a++) {
+    for (int b = a; b < s; b++) {
+      g[a * s + b] = g[b * s + a] =
+          s21_dot_kernel(c + idx[a] * p, c + idx[b] * p, p);
+    }
+  }
+
+  if (bj == bi + 1 || bi == bj) {
+    rotate_pairs(g, s, 0, ni, 0, ni, tiny, &rot);
+  }
+  if (last) {
+    rotate_pairs(g, s, ni, s, ni, s, tiny, &rot);
+  }
+  rotate_pairs(g, s, 0, ni, ni, s, tiny, &rot);
+
+  if (4 * rot.count > s * s) {
+    for (int r = 0; r < s; r++) {
+      memcpy(rows + r * p, c + idx[r] * p, p * sizeof(double));
+      memcpy(v + r * q, vt + idx[r] * q, q * sizeof(double));
+    }
+    s21_gemm(s, p, s, rot.m, s, rows, p, out, p, threads);
+    for (int r = 0; r < s; r++) {
+      memcpy(c + idx[r] * p, out + r * p, p * sizeof(double));
+    }
+    s21_gemm(s, q, s, rot.m, s, v, q, out, q, threads);
+    for (int r = 0; r < s; r++) {
+      memcpy(vt + idx[r] * q, out + r * q, q * sizeof(double));
+    }
+  } else {
+    for (int r = 0; r < rot.count; r++) {
+      rotate(c + idx[rot.a[r]] * p, c + idx[rot.b[r]] * p, p, rot.cs[r],
+             rot.sn[r]);
+      rotate(vt + idx[rot.a[r]] * q, vt + idx[rot.b[r]] * q, q, rot.cs[r],
+             rot.sn[r]);
+    }
+  }
+
+  return rot.count > 0;
+}
+
+// rows of c (length p) from index from on replace zero singular vectors: the
+// unit vector farthest from the span of the rows before, orthogonalized
+// against them twice (classical gram-schmidt with reorthogonalization)
+static void complete_basis(double *c, int p, int from, int q) {
+  double best, rest, norm, proj;
+  int t;
+
+  for (int i = from; i < q; i++) {
+    double *ci = c + i * p;
+
+    t = 0;
+    best = -1.0;
+    for (int k = 0; k < p; k++) {
+      rest = 1.0;
+      for (int j = 0; j < i; j++) {
+        rest -= c[j * p + k] * c[j * p + k];
+      }
+      if (rest > best) {
+        best = rest;
+        t = k;
+      }
+    }
+
+    for (int k = 0; k < p; k++) {
+      ci[k] = k == t;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      for (int j = 0; j < i; j++) {
+        proj = dot(c + j * p, ci, p);
+        for (int k = 0; k < p; k++) {
+          ci[k] -= proj * c[j * p + k];
+        }
+      }
+    }
+    norm = sqrt(dot(ci, ci, p));
+    for (int k = 0; k < p; k++) {
+      ci[k] /= norm;
+    }
+  }
+}
+
+// one-sided block jacobi on the q rows of c (length p, p >= q), vt collects
+// the right rotations and the row norms become the singular values; rows
+// no longer than eps * |A|_F, which only rank-deficient input leaves, are
+// completed to an orthonormal set
+static int jacobi_svd(double *c, int p, int q, double *vt, double *sigma,
+                      int *sweeps, double *work, int threads) {
+  int err = OK, rotated = 1, blocks = (q + SVD_BLOCK - 1) / SVD_BLOCK;
+  int rank = q;
+  double tiny = 0.0;
+
+  for (int i = 0; i < q; i++) {
+    tiny += dot(c + i * p, c + i * p, p);
+  }
+  tiny *= DBL_EPSILON * DBL_EPSILON;
+
+  for (int i = 0; i < q; i++) {
+    for (int j = 0; j < q; j++) {
+      vt[i * q + j] = i == j ? 1.0 : 0.0;
+    }
+  }
+
+  while (rotated && err == OK) {
+    if (*sweeps >= SVD_MAX_SWEEPS) {
+      err = CALCERR;
+      break;
+    }
+    (*sweeps)++;
+    rotated = 0;
+
+    for (int bi = 0; bi < blocks; bi++) {
+      for (int bj = blocks == 1 ? bi : bi + 1; bj < blocks; bj++) {
+        rotated |= jacobi_pair(c, p, vt, q, bi, bj,
+                               bi == 0 && bj == blocks - 1, tiny, work,
+                               threads);
+      }
+    }
+  }
+
+  for (int i = 0; i < q; i++) {
+    sigma[i] = sqrt(dot(c + i * p, c + i * p, p));
+  }
+
+  sort_values(sigma, q, 1, c, p, vt, q);
+
+  while (rank > 0 && !(sigma[rank - 1] * sigma[rank - 1] > tiny)) {
+    rank--;
+  }
+  for (int i = 0; i < rank; i++) {
+    for (int k = 0; k < p; k++) {
+      c[i * p + k] /= sigma[i];
+    }
+  }
+  complete_basis(c, p, rank, q);
+
+  return err;
+}
+
+int s21_svd_matrix(matrix_t *A, matrix_t *U, matrix_t *S, matrix_t *V,
+                   int *iterations) {
+  return s21_svd_matrix_ctx(NULL, A, U, S, V, iterations);
+}
+
+int s21_svd_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *U,
+                       matrix_t *S, matrix_t *V, int *iterations) {
+  int err = OK;
+  int m, n, p, q, tall, sweeps = 0;
+  double *c, *vt, *sigma, *work;
+  matrix_t *left, *right;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_finite_inputs(ctx, A, NULL, 1);
+
+  if (err != OK) {
+    return err;
+  }
+
+  m = A->rows;
+  n = A->columns;
+  tall = m >= n;
+  p = tall ? m : n;
+  q = tall ? n : m;
+  c = s21_workspace(
+      ctx, ((size_t)p * q + (size_t)q * q + q + jacobi_work(p, q)) *
+               sizeof(double));
+
+  if (c == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  vt = c + p * q;
+  sigma = vt + q * q;
+  work = sigma + q;
+
+  // rows of c are the columns of A, or of A^T when A is wide
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      if (tall) {
+        c[j * p + i] = A->matrix[i][j];
+      } else {
+        c[i * p + j] = A->matrix[i][j];
+      }
+    }
+  }
+
+  err = jacobi_svd(c, p, q, vt, sigma, &sweeps, work, ctx->threads);
+
+  if (iterations != NULL) {
+    *iterations = sweeps;
+  }
+
+  // for a wide A the factors of A^T swap roles
+  left = tall ? U : V;
+  right = tall ? V : U;
+
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, p, q, left);
+  }
+
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, q, 1, S);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, left);
+    }
+  }
+
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, q, q, right);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, left);
+      s21_remove_matrix_ctx(ctx, S);
+    }
+  }
+
+  if (err == OK) {
+    for (int j = 0; j < q; j++) {
+      S->matrix[j][0] = sigma[j];
+      for (int i = 0; i < p; i++) {
+        left->matrix[i][j] = c[j * p + i];
+      }
+      for (int i = 0; i < q; i++) {
+        right->matrix[i][j] = vt[j * q + i];
+      }
+    }
+  }
+
+  s21_workspace_release(ctx, c);
+
+  return err;
+}
+
+int s21_qr_matrix(matrix_t *A, matrix_t *Q, matrix_t *R) {
+  return s21_qr_matrix_ctx(NULL, A, Q, R);
+}
+
+// householder vectors are applied a row at a time: w = v^T X first, then
+// X -= beta * v * w, so every pass streams contiguous rows
+static void apply_reflector(double *x, int ldx, const double *r, int ldr,
+                            int k, int m, int c0, int c1, double beta,
+                            double *w) {
+  for (int j = c0; j < c1; j++) {
+    w[j] = x[k * ldx + j];
+  }
+  for (int i = k + 1; i < m; i++) {
+    double vi = r[i * ldr + k];
+    for (int j = c0; j < c1; j++) {
+      w[j] += vi * x[i * ldx + j];
+    }
+  }
+  for (int j = c0; j < c1; j++) {
+    w[j] *= beta;
+    x[k * ldx + j] -= w[j];
+  }
+  for (int i = k + 1; i < m; i++) {
+    double vi = r[i * ldr + k];
+    for (int j = c0; j < c1; j++) {
+      x[i * ldx + j] -= vi * w[j];
+    }
+  }
+}
+
+// rows of vt are the reflectors k0..k0 + w of qr on rows [k0, m), unit at
+// their own column, their tails read from below the diagonal of r
+static void qr_reflectors(const double *r, int m, int n, int k0, int w,
+                          double *vt) {
+  int len = m - k0;
+
+  for (int p = 0; p < w; p++) {
+    for (int i = 0; i < len; i++) {
+      vt[p * len + i] = i < p ? 0.0 : i == p ? 1.0 : r[(k0 + i) * n + k0 + p];
+    }
+  }
+}
+
+int s21_qr_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *Q,
+                      matrix_t *R) {
+  int err = OK;
+  int m, n, w;
+  double *r, *beta, *w_row, *vt, *t, *work, norm, alpha, v0;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows < A->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  err = s21_finite_inputs(ctx, A, NULL, 1);
+
+  if (err != OK) {
+    return err;
+  }
+
+  m = A->rows;
+  n = A->columns;
+  w = min_int(REFLECTOR_BLOCK, n);
+  r = s21_workspace(ctx, ((size_t)m * n + 2 * (size_t)n + (size_t)w * m +
+                          (size_t)w * w + BLOCK_WORK(w, m, n)) *
+                             sizeof(double));
+
+  if (r == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  beta = r + m * n;
+  w_row = beta + n;
+  vt = w_row + n;
+  t = vt + w * m;
+  work = t + w * w;
+
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      r[i * n + j] = A->matrix[i][j];
+    }
+  }
+
+  // v is scaled so that v_k = 1 and its tail is kept below the diagonal; the
+  // reflectors of a panel reach the columns right of it as one block
+  for (int k0 = 0; k0 < n; k0 += REFLECTOR_BLOCK) {
+    w = min_int(REFLECTOR_BLOCK, n - k0);
+
+    for (int k = k0; k < k0 + w; k++) {
+      norm = 0.0;
+      for (int i = k; i < m; i++) {
+        norm = hypot(norm, r[i * n + k]);
+      }
+
+      beta[k] = 0.0;
+      if (norm != 0.0) {
+        alpha = r[k * n + k] > 0 ? -norm : norm;
+        v0 = r[k * n + k] - alpha;
+        for (int i = k + 1; i < m; i++) {
+          r[i * n + k] /= v0;
+        }
+        beta[k] = -v0 / alpha;
+        apply_reflector(r, n, r, n, k, m, k + 1, k0 + w, beta[k], w_row);
+        r[k * n + k] = alpha;
+      }
+    }
+
+    if (k0 + w < n) {
+      qr_reflectors(r, m, n, k0, w, vt);
+      block_factor(vt, w, m - k0, beta + k0, t);
+      apply_block(vt, t, w, m - k0, 1, r + k0 * n + k0 + w, n, n - k0 - w,
+                  work, ctx->threads);
+    }
+  }
+
+  err = s21_create_matrix_ctx(ctx, m, n, Q);
+
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, n, n, R);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, Q);
+    }
+  }
+
+  // Q = H_0 ... H_{n-1} applied to the first n columns of I, last block first
+  if (err == OK) {
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) {
+        Q->matrix[i][j] = i == j ? 1.0 : 0.0;
+        if (i < n) {
+          R->matrix[i][j] = j >= i ? r[i * n + j] : 0.0;
+        }
+      }
+    }
+    for (int k0 = (n - 1) / REFLECTOR_BLOCK * REFLECTOR_BLOCK; k0 >= 0;
+         k0 -= REFLECTOR_BLOCK) {
+      w = min_int(REFLECTOR_BLOCK, n - k0);
+      qr_reflectors(r, m, n, k0, w, vt);
+      block_factor(vt, w, m - k0, beta + k0, t);
+      apply_block(vt, t, w, m - k0, 0, Q->matrix[0] + k0 * n + k0, n, n - k0,
+                  work, ctx->threads);
+    }
+  }
+
+  s21_workspace_release(ctx, r);
+
+  return err;
+}
@@ -0,0 +1,96 @@
+#include "s21_internal.h"
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+
+// flush-to-zero and denormals-are-zero bits of mxcsr
+#define MXCSR_FTZ 0x8000u
+#define MXCSR_DAZ 0x0040u
+
+unsigned s21_fp_state(void) { return _mm_getcsr(); }
+
+void s21_fp_restore(unsigned state) { _mm_setcsr(state); }
+
+int s21_fp_flushing(void) { return (_mm_getcsr() & MXCSR_DAZ) != 0; }
+
+unsigned s21_fp_enter(s21_context_t *ctx) {
+  unsigned saved = _mm_getcsr();
+
+  if (ctx->flush_denormals) {
+    _mm_setcsr(saved | MXCSR_FTZ | MXCSR_DAZ);
+  }
+
+  return saved;
+}
+
+void s21_fp_leave(unsigned saved) { _mm_setcsr(saved); }
+
+#else
+
+// no portable flush control elsewhere, subnormals keep their ieee behavior
+unsigned s21_fp_state(void) { return 0; }
+
+void s21_fp_restore(unsigned state) { (void)state; }
+
+int s21_fp_flushing(void) { return 0; }
+
+unsigned s21_fp_enter(s21_context_t *ctx) {
+  (void)ctx;
+  return 0;
+}
+
+void s21_fp_leave(unsigned saved) { (void)saved; }
+
+#endif
+
+// x - x is 0 for finite x and nan for nan or inf, so one sum tells them apart
+// without a branch per element
+int s21_finite_kernel(const double *x, size_t n) {
+  v4d acc = {0}, a;
+  double sum = 0.0;
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    LOAD4(a, x + i);
+    acc += a - a;
+  }
+  for (; i < n; i++) {
+    sum += x[i] - x[i];
+  }
+  sum += (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+  return sum == 0.0;
+}
+
+// nan or inf in the inputs, checked when the context asks for it or always
+// for the factorizations and iterations, where a zero pivot column would end
+// lu before reaching them and a nan never converges; a missing matrix stays
+// WRONGMAT
+int s21_finite_inputs(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                      int always) {
+  int err = OK;
+
+  if (always || ctx->check_finite) {
+    err = s21_check_finite(A);
+    if (err == OK && B != NULL) {
+      err = s21_check_finite(B);
+    }
+  }
+
+  return err;
+}
+
+int s21_check_finite(matrix_t *A) {
+  int err = OK;
+
+  if (A == NULL || A->matrix == NULL || A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (!s21_finite_kernel(A->matrix[0], (size_t)A->rows * A->columns)) {
+    err = NONFINITE;
+  }
+
+  return err;
+}
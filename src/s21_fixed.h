@@ -0,0 +1,153 @@
+#ifndef C6_S21_MATRIX_0_S21_FIXED_H
+#define C6_S21_MATRIX_0_S21_FIXED_H
+
+#include <float.h>
+
+#include "s21_matrix.h"
+
+// stack matrices of order 2..8, every loop has a constant trip count and is
+// unrolled by the compiler; only s21_matN_to_matrix touches the heap
+#define S21_UNROLL _Pragma("GCC unroll 8")
+
+#define S21_DEFINE_FIXED(N)                                                   \
+  typedef struct s21_mat##N {                                                 \
+    double m[N][N];                                                           \
+  } s21_mat##N##_t;                                                           \
+                                                                              \
+  static inline void s21_mat##N##_mult(const s21_mat##N##_t *A,               \
+                                       const s21_mat##N##_t *B,               \
+                                       s21_mat##N##_t *result) {              \
+    s21_mat##N##_t r;                                                         \
+    S21_UNROLL for (int i = 0; i < N; i++) {                                  \
+      S21_UNROLL for (int j = 0; j < N; j++) {                                \
+        r.m[i][j] = A->m[i][0] * B->m[0][j];                                  \
+        S21_UNROLL for (int k = 1; k < N; k++) {                              \
+          r.m[i][j] += A->m[i][k] * B->m[k][j];                               \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    *result = r;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline void s21_mat##N##_transpose(const s21_mat##N##_t *A,          \
+                                            s21_mat##N##_t *result) {         \
+    s21_mat##N##_t r;                                                         \
+    S21_UNROLL for (int i = 0; i < N; i++) {                                  \
+      S21_UNROLL for (int j = 0; j < N; j++) { r.m[j][i] = A->m[i][j]; }      \
+    }                                                                         \
+    *result = r;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline double s21_mat##N##_determinant(const s21_mat##N##_t *A) {    \
+    s21_mat##N##_t a = *A;                                                    \
+    double det = 1.0, tmp;                                                    \
+    S21_UNROLL for (int k = 0; k < N; k++) {                                  \
+      int p = k;                                                              \
+      S21_UNROLL for (int i = k + 1; i < N; i++) {                            \
+        p = fabs(a.m[i][k]) > fabs(a.m[p][k]) ? i : p;                        \
+      }                                                                       \
+      if (a.m[p][k] == 0) {                                                   \
+        return 0.0;                                                           \
+      }                                                                       \
+      if (p != k) {                                                           \
+        S21_UNROLL for (int j = k; j < N; j++) {                              \
+          tmp = a.m[k][j];                                                    \
+          a.m[k][j] = a.m[p][j];                                              \
+          a.m[p][j] = tmp;                                                    \
+        }                                                                     \
+        det = -det;                                                           \
+      }                                                                       \
+      det *= a.m[k][k];                                                       \
+      S21_UNROLL for (int i = k + 1; i < N; i++) {                            \
+        double l = a.m[i][k] / a.m[k][k];                                     \
+        S21_UNROLL for (int j = k + 1; j < N; j++) {                          \
+          a.m[i][j] -= l * a.m[k][j];                                         \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    return det;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline int s21_mat##N##_inverse(const s21_mat##N##_t *A,            \
+                                         s21_mat##N##_t *result) {           \
+    s21_mat##N##_t a = *A, r;                                                 \
+    double max = 0.0, tmp;                                                    \
+    S21_UNROLL for (int i = 0; i < N; i++) {                                  \
+      S21_UNROLL for (int j = 0; j < N; j++) {                                \
+        max = fmax(max, fabs(a.m[i][j]));                                     \
+        r.m[i][j] = i == j ? 1.0 : 0.0;                                       \
+      }                                                                       \
+    }                                                                         \
+    S21_UNROLL for (int k = 0; k < N; k++) {                                  \
+      int p = k;                                                              \
+      S21_UNROLL for (int i = k + 1; i < N; i++) {                            \
+        p = fabs(a.m[i][k]) > fabs(a.m[p][k]) ? i : p;                        \
+      }                                                                       \
+      if (fabs(a.m[p][k]) <= N * DBL_EPSILON * max) {                         \
+        return CALCERR;                                                       \
+      }                                                                       \
+      if (p != k) {                                                           \
+        S21_UNROLL for (int j = 0; j < N; j++) {                              \
+          tmp = a.m[k][j];                                                    \
+          a.m[k][j] = a.m[p][j];                                              \
+          a.m[p][j] = tmp;                                                    \
+          tmp = r.m[k][j];                                                    \
+          r.m[k][j] = r.m[p][j];                                              \
+          r.m[p][j] = tmp;                                                    \
+        }                                                                     \
+      }                                                                       \
+      tmp = 1.0 / a.m[k][k];                                                  \
+      S21_UNROLL for (int j = 0; j < N; j++) {                                \
+        a.m[k][j] *= tmp;                                                     \
+        r.m[k][j] *= tmp;                                                     \
+      }                                                                       \
+      S21_UNROLL for (int i = 0; i < N; i++) {                                \
+        double l = i == k ? 0.0 : a.m[i][k];                                  \
+        S21_UNROLL for (int j = 0; j < N; j++) {                              \
+          a.m[i][j] -= l * a.m[k][j];                                         \
+          r.m[i][j] -= l * r.m[k][j];                                         \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    *result = r;                                                              \
+    return OK;                                                                \
+  }                                                                           \
+                                                                              \
+  static inline int s21_mat##N##_from_matrix(matrix_t *A,                     \
+                                             s21_mat##N##_t *result) {        \
+    if (A->matrix == NULL || A->rows <= 0 || A->columns <= 0) {               \
+      return WRONGMAT;                                                        \
+    }                                                                         \
+    if (A->rows != N || A->columns != N) {                                    \
+      return CALCERR;                                                         \
+    }                                                                         \
+    S21_UNROLL for (int i = 0; i < N; i++) {                                  \
+      S21_UNROLL for (int j = 0; j < N; j++) {                                \
+        result->m[i][j] = A->matrix[i][j];                                    \
+      }                                                                       \
+    }                                                                         \
+    return OK;                                                                \
+  }                                                                           \
+                                                                              \
+  static inline int s21_mat##N##_to_matrix(const s21_mat##N##_t *A,           \
+                                           matrix_t *result) {                \
+    int err = s21_create_matrix(N, N, result);                                \
+    if (err == OK) {                                                          \
+      S21_UNROLL for (int i = 0; i < N; i++) {                                \
+        S21_UNROLL for (int j = 0; j < N; j++) {                              \
+          result->matrix[i][j] = A->m[i][j];                                  \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    return err;                                                               \
+  }
+
+S21_DEFINE_FIXED(2)
+S21_DEFINE_FIXED(3)
+S21_DEFINE_FIXED(4)
+S21_DEFINE_FIXED(5)
+S21_DEFINE_FIXED(6)
+S21_DEFINE_FIXED(7)
+S21_DEFINE_FIXED(8)
+
+#endif  // C6_S21_MATRIX_0_S21_FIXED_H
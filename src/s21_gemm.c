@@ -0,0 +1,251 @@
+#include "s21_internal.h"
+
+// product size that is worth a pool trip
+#define GEMM_PARALLEL_MIN (1 << 21)
+
+// inner-dimension steps summed directly before pairwise merging
+#define PAIRWISE_STEPS 32
+
+typedef struct gemm_args {
+  int m;
+  int n;
+  int k;
+  const double *a;
+  int lda;
+  const double *b;
+  int ldb;
+  double *c;
+  int ldc;
+  int mode;
+  double *work;
+  size_t band_work;
+  int subtract;
+} gemm_args_t;
+
+// adds a_i[p0..p1) * b[p0..p1) to the row c, or subtracts it; the i-p-j
+// loop order lets the inner loop stream rows of b and c, and four steps of
+// p per pass keep each slice of c in a register while still adding in p order
+static void gemm_row_naive(const gemm_args_t *g, const double *ai, double *c,
+                           int p0, int p1) {
+  double sign = g->subtract ? -1.0 : 1.0;
+  int p = p0;
+
+  for (; p + 4 <= p1; p += 4) {
+    const double *b0 = g->b + p * g->ldb, *b1 = b0 + g->ldb;
+    const double *b2 = b1 + g->ldb, *b3 = b2 + g->ldb;
+    double x0 = sign * ai[p], x1 = sign * ai[p + 1];
+    double x2 = sign * ai[p + 2], x3 = sign * ai[p + 3];
+    v4d a0 = {x0, x0, x0, x0}, a1 = {x1, x1, x1, x1};
+    v4d a2 = {x2, x2, x2, x2}, a3 = {x3, x3, x3, x3}, b, s;
+    int j = 0;
+    for (; j + 4 <= g->n; j += 4) {
+      LOAD4(s, c + j);
+      LOAD4(b, b0 + j);
+      s += a0 * b;
+      LOAD4(b, b1 + j);
+      s += a1 * b;
+      LOAD4(b, b2 + j);
+      s += a2 * b;
+      LOAD4(b, b3 + j);
+      s += a3 * b;
+      STORE4(c + j, s);
+    }
+    for (; j < g->n; j++) {
+      c[j] = c[j] + x0 * b0[j] + x1 * b1[j] + x2 * b2[j] + x3 * b3[j];
+    }
+  }
+  for (; p < p1; p++) {
+    const double *bp = g->b + p * g->ldb;
+    double aip = sign * ai[p];
+    v4d av = {aip, aip, aip, aip}, b, s;
+    int j = 0;
+    for (; j + 4 <= g->n; j += 4) {
+      LOAD4(b, bp + j);
+      LOAD4(s, c + j);
+      s += av * b;
+      STORE4(c + j, s);
+    }
+    for (; j < g->n; j++) {
+      c[j] += aip * bp[j];
+    }
+  }
+}
+
+// blocks of PAIRWISE_STEPS are merged like a binary counter, level h holds
+// the sum of 2^h blocks, so the error grows with log k instead of k
+static int pairwise_levels(int k) {
+  int blocks = (k + PAIRWISE_STEPS - 1) / PAIRWISE_STEPS, levels = 1;
+
+  while ((1 << levels) <= blocks) {
+    levels++;
+  }
+
+  return levels;
+}
+
+static void gemm_row_pairwise(const gemm_args_t *g, const double *ai,
+                              double *ci, double *work) {
+  int n = g->n, levels = pairwise_levels(g->k), count = 0, h;
+  double *tmp = work + (size_t)levels * n;
+
+  for (int p0 = 0; p0 < g->k; p0 += PAIRWISE_STEPS) {
+    int p1 = p0 + PAIRWISE_STEPS < g->k ? p0 + PAIRWISE_STEPS : g->k;
+    memset(tmp, 0, n * sizeof(double));
+    gemm_row_naive(g, ai, tmp, p0, p1);
+    for (h = 0; count >> h & 1; h++) {
+      s21_axpy_kernel(1.0, work + (size_t)h * n, tmp, n);
+    }
+    memcpy(work + (size_t)h * n, tmp, n * sizeof(double));
+    count++;
+  }
+
+  memset(ci, 0, n * sizeof(double));
+  for (h = 0; h < levels; h++) {
+    if (count >> h & 1) {
+      s21_axpy_kernel(1.0, work + (size_t)h * n, ci, n);
+    }
+  }
+}
+
+// the row of c is the running sum and comp its running correction; dot2
+// also folds in the rounding error of every product
+static void gemm_row_compensated(const gemm_args_t *g, const double *ai,
+                                 double *ci, double *comp, int exact) {
+  int n = g->n;
+
+  memset(ci, 0, n * sizeof(double));
+  memset(comp, 0, n * sizeof(double));
+
+  for (int p = 0; p < g->k; p++) {
+    const double *bp = g->b + p * g->ldb;
+    double aip = ai[p];
+    v4d av = {aip, aip, aip, aip}, b, s, e, x;
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+      LOAD4(b, bp + j);
+      LOAD4(s, ci + j);
+      LOAD4(e, comp + j);
+      x = av * b;
+      if (exact) {
+        TWO_PROD_ERR(e, av, b, x);
+      }
+      TWO_SUM(s, e, x);
+      STORE4(ci + j, s);
+      STORE4(comp + j, e);
+    }
+    for (; j < n; j++) {
+      double xj = aip * bp[j];
+      if (exact) {
+        TWO_PROD_ERR(comp[j], aip, bp[j], xj);
+      }
+      TWO_SUM(ci[j], comp[j], xj);
+    }
+  }
+
+  for (int j = 0; j < n; j++) {
+    ci[j] += comp[j];
+  }
+}
+
+static void gemm_rows(const gemm_args_t *g, int r0, int r1, double *work) {
+  for (int i = r0; i < r1; i++) {
+    double *ci = g->c + i * g->ldc;
+    const double *ai = g->a + i * g->lda;
+    if (g->mode == ACCUM_PAIRWISE) {
+      gemm_row_pairwise(g, ai, ci, work);
+    } else if (g->mode == ACCUM_KAHAN || g->mode == ACCUM_DOT2) {
+      gemm_row_compensated(g, ai, ci, work, g->mode == ACCUM_DOT2);
+    } else {
+      if (!g->subtract) {
+        memset(ci, 0, g->n * sizeof(double));
+      }
+      gemm_row_naive(g, ai, ci, 0, g->k);
+    }
+  }
+}
+
+// each band gets its own slice of the scratch
+static void gemm_band(void *arg, int band, int r0, int r1) {
+  const gemm_args_t *g = arg;
+
+  gemm_rows(g, r0, r1, g->work != NULL ? g->work + band * g->band_work : NULL);
+}
+
+// rows of c go out in the same bands as its first touch
+static void gemm_run(gemm_args_t *g, int threads) {
+  if ((double)g->m * g->n * g->k >= GEMM_PARALLEL_MIN && threads != 1) {
+    s21_parallel_bands(threads, g->c, g->m, g->ldc, gemm_band, g);
+  } else {
+    gemm_rows(g, 0, g->m, g->work);
+  }
+}
+
+// doubles of scratch one band needs in the given mode
+static size_t band_work(int n, int k, int mode) {
+  size_t size = 0;
+
+  if (mode == ACCUM_PAIRWISE) {
+    size = (size_t)(pairwise_levels(k) + 1) * n;
+  } else if (mode == ACCUM_KAHAN || mode == ACCUM_DOT2) {
+    size = (size_t)n;
+  }
+
+  return size;
+}
+
+size_t s21_gemm_accum_size(int m, int n, int k, int mode) {
+  return (size_t)((m + BAND_ROWS - 1) / BAND_ROWS) * band_work(n, k, mode) *
+         sizeof(double);
+}
+
+// naive mode goes through s21_gemm and so through blas when built with it,
+// blas has no compensated products so the other modes always run here
+void s21_gemm_accum(int m, int n, int k, const double *a, int lda,
+                    const double *b, int ldb, double *c, int ldc, int threads,
+                    int mode, double *work) {
+  gemm_args_t g = {m, n, k, a, lda, b, ldb, c, ldc, mode, work,
+                   band_work(n, k, mode), 0};
+
+  if (g.band_work == 0) {
+    s21_gemm(m, n, k, a, lda, b, ldb, c, ldc, threads);
+  } else {
+    gemm_run(&g, threads);
+  }
+}
+
+#ifdef S21_USE_BLAS
+
+// row-major C = A * B is column-major C^T = B^T * A^T
+void s21_gemm(int m, int n, int k, const double *a, int lda, const double *b,
+              int ldb, double *c, int ldc, int threads) {
+  const double one = 1.0, zero = 0.0;
+
+  (void)threads;
+  dgemm_("N", "N", &n, &m, &k, &one, b, &ldb, a, &lda, &zero, c, &ldc);
+}
+
+void s21_gemm_sub(int m, int n, int k, const double *a, int lda,
+                  const double *b, int ldb, double *c, int ldc, int threads) {
+  const double one = 1.0, minus = -1.0;
+
+  (void)threads;
+  dgemm_("N", "N", &n, &m, &k, &minus, b, &ldb, a, &lda, &one, c, &ldc);
+}
+
+#else
+
+void s21_gemm(int m, int n, int k, const double *a, int lda, const double *b,
+              int ldb, double *c, int ldc, int threads) {
+  gemm_args_t g = {m, n, k, a, lda, b, ldb, c, ldc, ACCUM_NAIVE, NULL, 0, 0};
+
+  gemm_run(&g, threads);
+}
+
+void s21_gemm_sub(int m, int n, int k, const double *a, int lda,
+                  const double *b, int ldb, double *c, int ldc, int threads) {
+  gemm_args_t g = {m, n, k, a, lda, b, ldb, c, ldc, ACCUM_NAIVE, NULL, 0, 1};
+
+  gemm_run(&g, threads);
+}
+
+#endif
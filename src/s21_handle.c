@@ -0,0 +1,343 @@
+#include <stdatomic.h>
+
+#include "s21_internal.h"
+
+// a matrix from the default allocator shared by every handle cloned from the
+// same origin; clients only reach it through the functions below so the
+// layout can change behind them
+typedef struct storage {
+  matrix_t m;
+  atomic_int refs;
+} storage_t;
+
+struct s21_handle {
+  storage_t *s;
+};
+
+static int handle_valid(const s21_handle_t *h) {
+  return h != NULL && h->s != NULL && h->s->m.matrix != NULL;
+}
+
+static s21_handle_t *handle_new(storage_t *s) {
+  s21_handle_t *h = malloc(sizeof(s21_handle_t));
+
+  if (h != NULL) {
+    h->s = s;
+  }
+
+  return h;
+}
+
+static void storage_release(storage_t *s) {
+  if (atomic_fetch_sub(&s->refs, 1) == 1) {
+    s21_remove_matrix(&s->m);
+    free(s);
+  }
+}
+
+// wraps a freshly computed matrix, which is removed if the handle can't be
+// allocated
+static int adopt(int err, matrix_t *m, s21_handle_t **result) {
+  storage_t *s;
+
+  if (err != OK) {
+    return err;
+  }
+
+  s = malloc(sizeof(storage_t));
+  *result = s != NULL ? handle_new(s) : NULL;
+  if (*result == NULL) {
+    free(s);
+    s21_remove_matrix(m);
+    err = WRONGMAT;
+  } else {
+    s->m = *m;
+    atomic_init(&s->refs, 1);
+  }
+
+  return err;
+}
+
+// the first write through a handle whose storage is shared takes a private
+// copy; a sole owner writes in place, a new clone could only come from this
+// same handle, which is not used concurrently with a write
+static int unshare(s21_handle_t *h) {
+  int err = OK;
+  storage_t *s;
+
+  if (atomic_load(&h->s->refs) > 1) {
+    s = malloc(sizeof(storage_t));
+    if (s == NULL) {
+      err = WRONGMAT;
+      return err;
+    }
+    err = s21_copy_matrix(&h->s->m, &s->m);
+    if (err != OK) {
+      free(s);
+      return err;
+    }
+    atomic_init(&s->refs, 1);
+    storage_release(h->s);
+    h->s = s;
+  }
+
+  return err;
+}
+
+int s21_abi_version(void) { return S21_ABI_VERSION; }
+
+int s21_handle_create(int rows, int columns, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_create_matrix(rows, columns, &m);
+  if (err == OK) {
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < columns; j++) {
+        m.matrix[i][j] = 0.0;
+      }
+    }
+  }
+
+  return adopt(err, &m, result);
+}
+
+int s21_handle_from_matrix(matrix_t *A, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (A == NULL || A->matrix == NULL || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_copy_matrix(A, &m);
+
+  return adopt(err, &m, result);
+}
+
+int s21_handle_to_matrix(s21_handle_t *h, matrix_t *result) {
+  int err = OK;
+
+  if (!handle_valid(h) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_copy_matrix(&h->s->m, result);
+
+  return err;
+}
+
+int s21_handle_clone(s21_handle_t *h, s21_handle_t **result) {
+  int err = OK;
+
+  if (!handle_valid(h) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  *result = handle_new(h->s);
+  if (*result == NULL) {
+    err = WRONGMAT;
+  } else {
+    atomic_fetch_add(&h->s->refs, 1);
+  }
+
+  return err;
+}
+
+int s21_handle_shared(const s21_handle_t *h) {
+  return handle_valid(h) ? atomic_load(&h->s->refs) : 0;
+}
+
+void s21_handle_release(s21_handle_t *h) {
+  if (h != NULL) {
+    if (h->s != NULL) {
+      storage_release(h->s);
+    }
+    free(h);
+  }
+}
+
+int s21_handle_rows(const s21_handle_t *h) {
+  return handle_valid(h) ? h->s->m.rows : 0;
+}
+
+int s21_handle_columns(const s21_handle_t *h) {
+  return handle_valid(h) ? h->s->m.columns : 0;
+}
+
+int s21_handle_get(const s21_handle_t *h, int row, int column,
+                   double *value) {
+  int err = OK;
+
+  if (!handle_valid(h) || value == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+  if (row < 0 || row >= h->s->m.rows || column < 0 ||
+      column >= h->s->m.columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  *value = h->s->m.matrix[row][column];
+
+  return err;
+}
+
+int s21_handle_set(s21_handle_t *h, int row, int column, double value) {
+  int err = OK;
+
+  if (!handle_valid(h)) {
+    err = WRONGMAT;
+    return err;
+  }
+  if (row < 0 || row >= h->s->m.rows || column < 0 ||
+      column >= h->s->m.columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  err = unshare(h);
+  if (err == OK) {
+    h->s->m.matrix[row][column] = value;
+  }
+
+  return err;
+}
+
+double *s21_handle_data(s21_handle_t *h, int *stride) {
+  double *data = NULL;
+
+  if (handle_valid(h) && unshare(h) == OK) {
+    data = h->s->m.matrix[0];
+    if (stride != NULL) {
+      *stride = h->s->m.columns;
+    }
+  }
+
+  return data;
+}
+
+const double *s21_handle_read_data(const s21_handle_t *h, int *stride) {
+  const double *data = NULL;
+
+  if (handle_valid(h)) {
+    data = h->s->m.matrix[0];
+    if (stride != NULL) {
+      *stride = h->s->m.columns;
+    }
+  }
+
+  return data;
+}
+
+int s21_handle_eq(s21_handle_t *A, s21_handle_t *B) {
+  return handle_valid(A) && handle_valid(B) ? s21_eq_matrix(&A->s->m, &B->s->m)
+                                            : FAILURE;
+}
+
+int s21_handle_sum(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || !handle_valid(B) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_sum_matrix(&A->s->m, &B->s->m, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_sub(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || !handle_valid(B) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_sub_matrix(&A->s->m, &B->s->m, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_mult_number(s21_handle_t *A, double number,
+                           s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_mult_number(&A->s->m, number, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_mult(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || !handle_valid(B) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_mult_matrix(&A->s->m, &B->s->m, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_transpose(s21_handle_t *A, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_transpose(&A->s->m, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_inverse(s21_handle_t *A, s21_handle_t **result) {
+  matrix_t m;
+  int err = OK;
+
+  if (!handle_valid(A) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = adopt(s21_inverse_matrix(&A->s->m, &m), &m, result);
+
+  return err;
+}
+
+int s21_handle_determinant(s21_handle_t *A, double *result) {
+  int err = OK;
+
+  if (!handle_valid(A) || result == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_determinant(&A->s->m, result);
+
+  return err;
+}
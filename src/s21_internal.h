@@ -0,0 +1,164 @@
+#ifndef C6_S21_MATRIX_0_S21_INTERNAL_H
+#define C6_S21_MATRIX_0_S21_INTERNAL_H
+
+#include <string.h>
+
+#include "s21_matrix.h"
+
+// four doubles per step, one avx or two sse2 registers; vectors stay local
+// and go through memcpy so unaligned rows are fine and the abi is untouched
+typedef double v4d __attribute__((vector_size(32)));
+
+#define LOAD4(v, p) memcpy(&(v), (p), sizeof(v4d))
+#define STORE4(p, v) memcpy((p), &(v), sizeof(v4d))
+
+// error-free transforms on double or v4d operands: TWO_SUM sets s to s + x
+// and adds the rounding error to e (Knuth, branch free); TWO_PROD_ERR adds
+// the rounding error of p = a * b to e, which is exactly fma(a, b, -p) when
+// the target has fused multiply-add (-march with fma defines FP_FAST_FMA);
+// otherwise Dekker splitting recovers it without fma, exact unless |a| or |b|
+// exceeds about 1e300; both rely on the default -ffp-contract=off of -std=c11
+#define TWO_SUM(s, e, x)                   \
+  do {                                     \
+    __typeof__(s) t_ = (s) + (x);          \
+    __typeof__(s) z_ = t_ - (s);           \
+    (e) += ((s) - (t_ - z_)) + ((x)-z_);   \
+    (s) = t_;                              \
+  } while (0)
+
+#ifdef FP_FAST_FMA
+static inline double s21_prod_err(double a, double b, double p) {
+  return fma(a, b, -p);
+}
+
+// four scalar fma calls, gcc folds them into one vector fma
+static inline v4d s21_prod_err4(v4d a, v4d b, v4d p) {
+  v4d e = {fma(a[0], b[0], -p[0]), fma(a[1], b[1], -p[1]),
+           fma(a[2], b[2], -p[2]), fma(a[3], b[3], -p[3])};
+
+  return e;
+}
+
+#define TWO_PROD_ERR(e, a, b, p) \
+  ((e) += _Generic((p), v4d: s21_prod_err4, default: s21_prod_err)(a, b, p))
+#else
+#define S21_SPLITTER 134217729.0
+
+#define TWO_PROD_ERR(e, a, b, p)                                        \
+  do {                                                                  \
+    __typeof__(p) ca_ = S21_SPLITTER * (a), cb_ = S21_SPLITTER * (b);   \
+    __typeof__(p) ah_ = ca_ - (ca_ - (a)), bh_ = cb_ - (cb_ - (b));     \
+    __typeof__(p) al_ = (a)-ah_, bl_ = (b)-bh_;                         \
+    (e) += (((ah_ * bh_ - (p)) + ah_ * bl_) + al_ * bh_) + al_ * bl_;   \
+  } while (0)
+#endif
+
+// per-caller state behind s21_context_t, see s21_matrix.h; the defaults are
+// malloc, all pool threads, naive accumulation and every flag off;
+// workspace_busy is set while a call holds the workspace
+struct s21_context {
+  s21_allocator_t allocator;
+  int threads;
+  void *workspace;
+  size_t workspace_size;
+  int workspace_busy;
+  int accumulation;
+  int flush_denormals;
+  int check_finite;
+  int first_touch;
+};
+
+// nothing declared here is exported from the shared library
+#pragma GCC visibility push(hidden)
+
+// context helpers; s21_workspace claims the context's workspace until the
+// matching release and returns NULL while an enclosing call still holds it,
+// so a nested call fails instead of reallocating memory in use
+s21_context_t *s21_resolve_context(s21_context_t *ctx);
+void *s21_workspace(s21_context_t *ctx, size_t size);
+void s21_workspace_release(s21_context_t *ctx, void *ws);
+
+// inherit copies the settings and allocator of from, or the defaults for
+// NULL, into a context with no workspace; clear releases the workspace
+void s21_context_inherit(s21_context_t *ctx, s21_context_t *from);
+void s21_context_clear(s21_context_t *ctx);
+
+// floating-point environment: enter applies the context's flush mode and
+// returns the caller's state for leave; parallel loops run their tasks
+// under the state of the thread that started them; flushing tells whether
+// the calling thread reads subnormal operands as zero
+unsigned s21_fp_state(void);
+void s21_fp_restore(unsigned state);
+int s21_fp_flushing(void);
+unsigned s21_fp_enter(s21_context_t *ctx);
+void s21_fp_leave(unsigned saved);
+int s21_finite_kernel(const double *x, size_t n);
+
+// s21_check_finite on A and B (when not NULL) if always or ctx->check_finite
+int s21_finite_inputs(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                      int always);
+
+// zeroes a new matrix in parallel row bands, see s21_context_t.first_touch;
+// band_start is the first row of a band out of bands over rows of ld doubles
+// at data, with the edges on huge page boundaries once every band spans one
+void s21_first_touch(double *data, int rows, int columns, int threads);
+int s21_band_start(const double *data, int rows, int ld, int bands, int band);
+
+// work-stealing pool shared by async and parallel kernels
+typedef void (*s21_task_fn)(void *arg);
+typedef void (*s21_range_fn)(void *arg, int index);
+typedef void (*s21_band_fn)(void *arg, int band, int r0, int r1);
+
+// fewest rows and most bands of s21_parallel_bands, which prefers to run
+// band b of a row range on pool worker b, so kernels mostly find their rows
+// on the node that first touched them
+#define BAND_ROWS 32
+#define BAND_MAX 64
+
+int s21_pool_start(int threads);
+void s21_pool_stop(void);
+int s21_pool_size(void);
+int s21_pool_submit(s21_task_fn fn, void *arg);
+int s21_pool_help(void);
+void s21_parallel_for(int threads, int count, s21_range_fn fn, void *arg);
+void s21_parallel_bands(int threads, const double *data, int rows, int ld,
+                        s21_band_fn fn, void *arg);
+
+// dense kernels on row-major buffers with leading dimension lda; gemm sets
+// c = a * b and gemm_sub takes a * b off c
+int s21_lu_factor(double *a, int n, int lda, int *piv, double *det,
+                  int threads);
+void s21_gemm(int m, int n, int k, const double *a, int lda, const double *b,
+              int ldb, double *c, int ldc, int threads);
+void s21_gemm_sub(int m, int n, int k, const double *a, int lda,
+                  const double *b, int ldb, double *c, int ldc, int threads);
+size_t s21_gemm_accum_size(int m, int n, int k, int mode);
+void s21_gemm_accum(int m, int n, int k, const double *a, int lda,
+                    const double *b, int ldb, double *c, int ldc, int threads,
+                    int mode, double *work);
+double s21_dot_accum(const double *x, const double *y, int n, int mode);
+double s21_dot_kernel(const double *x, const double *y, int n);
+void s21_axpy_kernel(double alpha, const double *x, double *y, int n);
+double s21_nrm2_kernel(const double *x, int n);
+void s21_lu_solve(const double *lu, int n, int lda, const int *piv, double *b,
+                  int ldb, int nrhs, int threads);
+void s21_lu_inverse(const double *lu, int n, int lda, const int *piv,
+                    double *inv, double *work, int threads);
+
+#pragma GCC visibility pop
+
+#ifdef S21_USE_BLAS
+// fortran blas/lapack entry points; a row-major buffer is seen as the
+// column-major transpose, so the kernels above swap operands accordingly
+void dgemm_(const char *transa, const char *transb, const int *m, const int *n,
+            const int *k, const double *alpha, const double *a, const int *lda,
+            const double *b, const int *ldb, const double *beta, double *c,
+            const int *ldc);
+void dtrsm_(const char *side, const char *uplo, const char *transa,
+            const char *diag, const int *m, const int *n, const double *alpha,
+            const double *a, const int *lda, double *b, const int *ldb);
+void dgetri_(const int *n, double *a, const int *lda, const int *ipiv,
+             double *work, const int *lwork, int *info);
+#endif
+
+#endif  // C6_S21_MATRIX_0_S21_INTERNAL_H
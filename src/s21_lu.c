@@ -0,0 +1,460 @@
+#include "s21_internal.h"
+
+#ifdef S21_USE_BLAS
+
+// panels at most this wide are factored column by column
+#define LU_LEAF 16
+
+// applies the interchanges piv[k0..k1) to columns [j0, j1) of a column-major
+// matrix, a column at a time as dlaswp does
+static void swap_rows(double *a, int lda, const int *piv, int k0, int k1,
+                      int j0, int j1) {
+  double tmp, *col;
+
+  for (int j = j0; j < j1; j++) {
+    col = a + j * lda;
+    for (int i = k0; i < k1; i++) {
+      tmp = col[i];
+      col[i] = col[piv[i] - 1];
+      col[piv[i] - 1] = tmp;
+    }
+  }
+}
+
+// lu of the m x w column-major panel at p with pivots relative to its first
+// row; like the builtin kernel it divides by the pivot, where dgetrf scales
+// by its reciprocal and overflows when the pivot is subnormal
+static int factor_panel(double *p, int m, int w, int lda, int *piv) {
+  int info = 0;
+
+  for (int k = 0; k < w && k < m; k++) {
+    double *col = p + k * lda;
+    int r = k;
+
+    for (int i = k + 1; i < m; i++) {
+      if (fabs(col[i]) > fabs(col[r])) {
+        r = i;
+      }
+    }
+
+    piv[k] = r + 1;
+
+    if (col[r] == 0) {
+      info = info == 0 ? k + 1 : info;
+      continue;
+    }
+
+    if (r != k) {
+      swap_rows(p, lda, piv, k, k + 1, 0, w);
+    }
+
+    for (int i = k + 1; i < m; i++) {
+      col[i] /= col[k];
+    }
+    for (int j = k + 1; j < w; j++) {
+      double *cj = p + j * lda;
+      for (int i = k + 1; i < m; i++) {
+        cj[i] -= col[i] * cj[k];
+      }
+    }
+  }
+
+  return info;
+}
+
+// recursive lu of the m x w panel as in lapack dgetrf2 (m >= w): the left
+// half, then its interchanges, a triangular solve and a dgemm update on the
+// right half before that is factored in turn
+static int factor_recursive(double *p, int m, int w, int lda, int *piv) {
+  const double one = 1.0, minus_one = -1.0;
+  int w1 = w / 2, w2 = w - w1, rest = m - w1, info, right;
+
+  if (w <= LU_LEAF) {
+    return factor_panel(p, m, w, lda, piv);
+  }
+
+  info = factor_recursive(p, m, w1, lda, piv);
+  swap_rows(p, lda, piv, 0, w1, w1, w);
+
+  dtrsm_("L", "L", "N", "U", &w1, &w2, &one, p, &lda, p + w1 * lda, &lda);
+  dgemm_("N", "N", &rest, &w2, &w1, &minus_one, p + w1, &lda, p + w1 * lda,
+         &lda, &one, p + w1 * lda + w1, &lda);
+
+  right = factor_recursive(p + w1 * lda + w1, rest, w2, lda, piv + w1);
+  info = info == 0 && right != 0 ? w1 + right : info;
+  for (int i = w1; i < w; i++) {
+    piv[i] += w1;
+  }
+  swap_rows(p, lda, piv, w1, w, 0, w1);
+
+  return info;
+}
+
+// lu of A^T = P L U on the column-major view of the row-major buffer, with
+// the layout and 1-based pivots of dgetrf
+int s21_lu_factor(double *a, int n, int lda, int *piv, double *det,
+                  int threads) {
+  int info = 0;
+  double d = 1.0;
+
+  (void)threads;
+
+  // blas threads do not inherit the caller's daz, so under it they get the
+  // entries it would read as zero
+  if (s21_fp_flushing()) {
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        if (fpclassify(a[i * lda + j]) == FP_SUBNORMAL) {
+          a[i * lda + j] = copysign(0.0, a[i * lda + j]);
+        }
+      }
+    }
+  }
+
+  if (n > 0) {
+    info = factor_recursive(a, n, n, lda, piv);
+  }
+
+  if (det != NULL) {
+    for (int k = 0; k < n; k++) {
+      d *= piv[k] != k + 1 ? -a[k * lda + k] : a[k * lda + k];
+    }
+    *det = info == 0 ? d : 0.0;
+  }
+
+  return info == 0 ? OK : CALCERR;
+}
+
+// A X = B is X^T P L U = B^T on the column-major view: two right-side
+// triangular solves, then the interchanges undone in reverse on rows of b
+void s21_lu_solve(const double *lu, int n, int lda, const int *piv, double *b,
+                  int ldb, int nrhs, int threads) {
+  const double one = 1.0;
+  double tmp;
+
+  (void)threads;
+
+  dtrsm_("R", "U", "N", "N", &nrhs, &n, &one, lu, &lda, b, &ldb);
+  dtrsm_("R", "L", "N", "U", &nrhs, &n, &one, lu, &lda, b, &ldb);
+
+  for (int i = n - 1; i >= 0; i--) {
+    if (piv[i] - 1 != i) {
+      for (int j = 0; j < nrhs; j++) {
+        tmp = b[i * ldb + j];
+        b[i * ldb + j] = b[(piv[i] - 1) * ldb + j];
+        b[(piv[i] - 1) * ldb + j] = tmp;
+      }
+    }
+  }
+}
+
+// dgetri yields (A^T)^-1 column-major, which read row-major is A^-1
+void s21_lu_inverse(const double *lu, int n, int lda, const int *piv,
+                    double *inv, double *work, int threads) {
+  int info;
+
+  (void)threads;
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      inv[i * n + j] = lu[i * lda + j];
+    }
+  }
+
+  dgetri_(&n, inv, &n, piv, work, &n, &info);
+}
+
+#else
+
+// tile edge for the blocked factorization and the order it starts at
+#define LU_BLOCK 64
+#define LU_BLOCKED_MIN 192
+
+// k and w are the panel factored last, next_w the width of the one after
+// it, and the columns right of that are split into tiles of tile_w
+typedef struct lu_state {
+  double *a;
+  int n;
+  int lda;
+  int *piv;
+  int k;
+  int w;
+  int next_w;
+  int tiles;
+  int tile_w;
+  int singular;
+} lu_state_t;
+
+typedef struct lu_rhs {
+  const double *lu;
+  int n;
+  int lda;
+  const int *piv;
+  double *b;
+  int ldb;
+  int nrhs;
+  int tile_w;
+} lu_rhs_t;
+
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+static void swap_rows(double *a, double *b, int count) {
+  double tmp;
+
+  for (int j = 0; j < count; j++) {
+    tmp = a[j];
+    a[j] = b[j];
+    b[j] = tmp;
+  }
+}
+
+// the interchanges of rows k..k+w, applied to columns [c0, c1) only
+static void apply_swaps(lu_state_t *s, int k, int w, int c0, int c1) {
+  for (int i = k; i < k + w && c1 > c0; i++) {
+    if (s->piv[i] != i) {
+      swap_rows(s->a + i * s->lda + c0, s->a + s->piv[i] * s->lda + c0,
+                c1 - c0);
+    }
+  }
+}
+
+// columns [c0, c1) of rows k..k+w become L11^-1 times themselves
+static void solve_unit_lower(double *a, int lda, int k, int w, int c0,
+                             int c1) {
+  for (int i = k + 1; i < k + w; i++) {
+    for (int p = k; p < i; p++) {
+      s21_axpy_kernel(-a[i * lda + p], a + p * lda + c0, a + i * lda + c0,
+                      c1 - c0);
+    }
+  }
+}
+
+// columns [c0, c1) of rows k..k+w through U12 = L11^-1 A12, then the rows
+// below through A22 -= L21 U12
+static void update_columns(lu_state_t *s, int k, int w, int c0, int c1) {
+  double *a = s->a;
+  int lda = s->lda;
+
+  solve_unit_lower(a, lda, k, w, c0, c1);
+  s21_gemm_sub(s->n - k - w, c1 - c0, w, a + (k + w) * lda + k, lda,
+               a + k * lda + c0, lda, a + (k + w) * lda + c0, lda, 1);
+}
+
+// recursive factorization of the tall panel of columns [k, k + w); rows are
+// only swapped across the panel's own columns [c0, c1)
+static void factor_panel(lu_state_t *s, int k, int w, int c0, int c1) {
+  double *a = s->a;
+  int lda = s->lda, n = s->n;
+
+  if (w == 1) {
+    int p = k;
+    double max = fabs(a[k * lda + k]);
+
+    for (int i = k + 1; i < n; i++) {
+      if (fabs(a[i * lda + k]) > max) {
+        max = fabs(a[i * lda + k]);
+        p = i;
+      }
+    }
+
+    s->piv[k] = p;
+
+    if (max == 0) {
+      s->singular = 1;
+    } else {
+      if (p != k) {
+        swap_rows(a + k * lda + c0, a + p * lda + c0, c1 - c0);
+      }
+      for (int i = k + 1; i < n; i++) {
+        a[i * lda + k] /= a[k * lda + k];
+      }
+    }
+  } else {
+    int w1 = w / 2;
+
+    factor_panel(s, k, w1, c0, c1);
+    update_columns(s, k, w1, k + w1, k + w);
+    factor_panel(s, k + w1, w - w1, c0, c1);
+  }
+}
+
+// one stage after panel k: task 0 brings the next panel up to date and
+// factors it while the others update the tiles right of it, the last task
+// swaps the rows left of panel k; so each panel costs a single barrier
+static void stage_task(void *arg, int index) {
+  lu_state_t *s = arg;
+  int next = s->k + s->w;
+
+  if (index == 0) {
+    apply_swaps(s, s->k, s->w, next, next + s->next_w);
+    update_columns(s, s->k, s->w, next, next + s->next_w);
+    factor_panel(s, next, s->next_w, next, next + s->next_w);
+  } else if (index <= s->tiles) {
+    int c0 = next + s->next_w + (index - 1) * s->tile_w;
+    int c1 = min_int(c0 + s->tile_w, s->n);
+    if (c0 < c1) {
+      apply_swaps(s, s->k, s->w, c0, c1);
+      update_columns(s, s->k, s->w, c0, c1);
+    }
+  } else {
+    apply_swaps(s, s->k, s->w, 0, s->k);
+  }
+}
+
+static int lu_blocked(double *a, int n, int lda, int *piv, int threads) {
+  lu_state_t s = {a, n, lda, piv, 0, min_int(LU_BLOCK, n), 0, 0, 0, 0};
+  int parts = threads > 0 ? threads : s21_pool_size();
+
+  factor_panel(&s, 0, s.w, 0, s.w);
+  for (; s.k + s.w < n; s.k += s.w, s.w = s.next_w) {
+    int rest;
+    s.next_w = min_int(LU_BLOCK, n - s.k - s.w);
+    rest = n - s.k - s.w - s.next_w;
+    s.tiles = min_int(parts, (rest + LU_BLOCK - 1) / LU_BLOCK);
+    s.tile_w = s.tiles > 0 ? (rest + s.tiles - 1) / s.tiles : 0;
+    s21_parallel_for(threads, s.tiles + 2, stage_task, &s);
+  }
+  apply_swaps(&s, s.k, s.w, 0, s.k);
+
+  return s.singular ? CALCERR : OK;
+}
+
+static int lu_unblocked(double *a, int n, int lda, int *piv) {
+  int err = OK;
+  double max;
+  int p;
+
+  for (int k = 0; k < n; k++) {
+    p = k;
+    max = fabs(a[k * lda + k]);
+    for (int i = k + 1; i < n; i++) {
+      if (fabs(a[i * lda + k]) > max) {
+        max = fabs(a[i * lda + k]);
+        p = i;
+      }
+    }
+
+    piv[k] = p;
+
+    if (max == 0) {
+      err = CALCERR;
+      continue;
+    }
+
+    if (p != k) {
+      swap_rows(a + k * lda, a + p * lda, n);
+    }
+
+    for (int i = k + 1; i < n; i++) {
+      double *row = a + i * lda;
+      double l = row[k] / a[k * lda + k];
+      row[k] = l;
+      for (int j = k + 1; j < n; j++) {
+        row[j] -= l * a[k * lda + j];
+      }
+    }
+  }
+
+  return err;
+}
+
+int s21_lu_factor(double *a, int n, int lda, int *piv, double *det,
+                  int threads) {
+  int err;
+  double d = 1.0;
+
+  if (n >= LU_BLOCKED_MIN) {
+    err = lu_blocked(a, n, lda, piv, threads);
+  } else {
+    err = lu_unblocked(a, n, lda, piv);
+  }
+
+  if (det != NULL) {
+    for (int k = 0; k < n; k++) {
+      d *= piv[k] != k ? -a[k * lda + k] : a[k * lda + k];
+    }
+    *det = err == OK ? d : 0.0;
+  }
+
+  return err;
+}
+
+// forward then backward substitution a block of LU_BLOCK rows at a time,
+// the rest of the right-hand side is updated through gemm after each block
+static void solve_rhs(const double *lu, int n, int lda, const int *piv,
+                      double *b, int ldb, int nrhs) {
+  for (int i = 0; i < n; i++) {
+    if (piv[i] != i) {
+      swap_rows(b + i * ldb, b + piv[i] * ldb, nrhs);
+    }
+  }
+
+  for (int k = 0; k < n; k += LU_BLOCK) {
+    int w = min_int(LU_BLOCK, n - k);
+    for (int i = k + 1; i < k + w; i++) {
+      for (int p = k; p < i; p++) {
+        s21_axpy_kernel(-lu[i * lda + p], b + p * ldb, b + i * ldb, nrhs);
+      }
+    }
+    if (k + w < n) {
+      s21_gemm_sub(n - k - w, nrhs, w, lu + (k + w) * lda + k, lda,
+                   b + k * ldb, ldb, b + (k + w) * ldb, ldb, 1);
+    }
+  }
+
+  for (int k = (n - 1) / LU_BLOCK * LU_BLOCK; k >= 0; k -= LU_BLOCK) {
+    int w = min_int(LU_BLOCK, n - k);
+    for (int i = k + w - 1; i >= k; i--) {
+      double *bi = b + i * ldb;
+      double d = lu[i * lda + i];
+      for (int p = i + 1; p < k + w; p++) {
+        s21_axpy_kernel(-lu[i * lda + p], b + p * ldb, bi, nrhs);
+      }
+      for (int j = 0; j < nrhs; j++) {
+        bi[j] /= d;
+      }
+    }
+    if (k > 0) {
+      s21_gemm_sub(k, nrhs, w, lu + k, lda, b + k * ldb, ldb, b, ldb, 1);
+    }
+  }
+}
+
+// each participant solves one slice of the right-hand side columns
+static void rhs_tile(void *arg, int index) {
+  lu_rhs_t *r = arg;
+  int c0 = index * r->tile_w;
+
+  if (c0 < r->nrhs) {
+    solve_rhs(r->lu, r->n, r->lda, r->piv, r->b + c0, r->ldb,
+              min_int(r->tile_w, r->nrhs - c0));
+  }
+}
+
+void s21_lu_solve(const double *lu, int n, int lda, const int *piv, double *b,
+                  int ldb, int nrhs, int threads) {
+  int parts = threads > 0 ? threads : s21_pool_size();
+  int tiles = min_int(parts, (nrhs + LU_BLOCK - 1) / LU_BLOCK);
+  lu_rhs_t r = {lu, n, lda, piv, b, ldb, nrhs, (nrhs + tiles - 1) / tiles};
+
+  if (n >= LU_BLOCKED_MIN && tiles > 1) {
+    s21_parallel_for(threads, tiles, rhs_tile, &r);
+  } else {
+    solve_rhs(lu, n, lda, piv, b, ldb, nrhs);
+  }
+}
+
+void s21_lu_inverse(const double *lu, int n, int lda, const int *piv,
+                    double *inv, double *work, int threads) {
+  (void)work;
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      inv[i * n + j] = i == j ? 1.0 : 0.0;
+    }
+  }
+
+  s21_lu_solve(lu, n, lda, piv, inv, n, n, threads);
+}
+
+#endif
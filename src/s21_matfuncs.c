@@ -0,0 +1,326 @@
+#include "s21_internal.h"
+
+// pade degrees tried before scaling and the 1-norm bound of each one
+// (higham, the scaling and squaring method revisited, 2005)
+static const int pade_degrees[] = {3, 5, 7, 9, 13};
+static const double pade_theta[] = {1.495585217958292e-2,
+                                    2.539398330063230e-1,
+                                    9.504178996162932e-1,
+                                    2.097847961257068e0, 5.371920351148152e0};
+static const double pade_b3[] = {120, 60, 12, 1};
+static const double pade_b5[] = {30240, 15120, 3360, 420, 30, 1};
+static const double pade_b7[] = {17297280, 8648640, 1995840, 277200,
+                                 25200,    1512,    56,      1};
+static const double pade_b9[] = {17643225600.0, 8821612800.0, 2075673600.0,
+                                 302702400.0,   30270240.0,   2162160.0,
+                                 110880.0,      3960.0,       90.0,
+                                 1.0};
+static const double pade_b13[] = {
+    64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+    1187353796428800.0,  129060195264000.0,   10559470521600.0,
+    670442572800.0,      33522128640.0,       1323241920.0,
+    40840800.0,          960960.0,            16380.0,
+    182.0,               1.0};
+
+static void swap_buffers(double **a, double **b) {
+  double *tmp = *a;
+
+  *a = *b;
+  *b = tmp;
+}
+
+static void set_identity(double *a, int n) {
+  for (int i = 0; i < n * n; i++) {
+    a[i] = 0.0;
+  }
+  for (int i = 0; i < n; i++) {
+    a[i * n + i] = 1.0;
+  }
+}
+
+static int copy_out(s21_context_t *ctx, const double *a, int n,
+                    matrix_t *result) {
+  int err = s21_create_matrix_ctx(ctx, n, n, result);
+
+  if (err == OK) {
+    for (int i = 0; i < n * n; i++) {
+      result->matrix[0][i] = a[i];
+    }
+  }
+
+  return err;
+}
+
+int s21_matrix_pow(matrix_t *A, long long k, matrix_t *result) {
+  return s21_matrix_pow_ctx(NULL, A, k, result);
+}
+
+int s21_matrix_pow_ctx(s21_context_t *ctx, matrix_t *A, long long k,
+                       matrix_t *result) {
+  int err = OK;
+  int n, mode, started = 0;
+  unsigned long long e;
+  double *ws, *base, *acc, *tmp, *work;
+  matrix_t inverse;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows != A->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  err = s21_finite_inputs(ctx, A, NULL, 1);
+
+  if (err != OK) {
+    return err;
+  }
+
+  if (k < 0) {
+    err = s21_inverse_matrix_ctx(ctx, A, &inverse);
+    if (err == OK) {
+      err = s21_matrix_pow_ctx(ctx, &inverse, -(k + 1), result);
+      // A^k = (A^-1)^(-k) with the last factor applied here keeps -k in range
+      if (err == OK) {
+        matrix_t last = *result;
+        err = s21_mult_matrix_ctx(ctx, &last, &inverse, result);
+        s21_remove_matrix_ctx(ctx, &last);
+      }
+      s21_remove_matrix_ctx(ctx, &inverse);
+    }
+    return err;
+  }
+
+  n = A->rows;
+  mode = ctx->accumulation;
+  ws = s21_workspace(ctx, 3 * (size_t)n * n * sizeof(double) +
+                              s21_gemm_accum_size(n, n, n, mode));
+
+  if (ws == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  base = ws;
+  acc = base + n * n;
+  tmp = acc + n * n;
+  work = tmp + n * n;
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      base[i * n + j] = A->matrix[i][j];
+    }
+  }
+
+  // the three buffers rotate, so each step is one multiply and no allocation;
+  // the multiplies sum like mult_matrix under the context's accumulation
+  for (e = (unsigned long long)k; e != 0; e >>= 1) {
+    if (e & 1) {
+      if (started) {
+        s21_gemm_accum(n, n, n, acc, n, base, n, tmp, n, ctx->threads, mode,
+                       work);
+        swap_buffers(&acc, &tmp);
+      } else {
+        for (int i = 0; i < n * n; i++) {
+          acc[i] = base[i];
+        }
+        started = 1;
+      }
+    }
+    if (e > 1) {
+      s21_gemm_accum(n, n, n, base, n, base, n, tmp, n, ctx->threads, mode,
+                     work);
+      swap_buffers(&base, &tmp);
+    }
+  }
+
+  if (!started) {
+    set_identity(acc, n);
+  }
+
+  err = copy_out(ctx, acc, n, result);
+  s21_workspace_release(ctx, ws);
+
+  return err;
+}
+
+// nan in any column makes the norm nan, fmax would drop it
+static double norm1(const double *a, int n) {
+  double norm = 0.0, sum;
+
+  for (int j = 0; j < n; j++) {
+    sum = 0.0;
+    for (int i = 0; i < n; i++) {
+      sum += fabs(a[i * n + j]);
+    }
+    norm = sum > norm || isnan(sum) ? sum : norm;
+  }
+
+  return norm;
+}
+
+// dst = sum of b[j] * pw[j / 2] over j of the given parity, pw[0] being I
+static void pade_sum(double *dst, double *const *pw, const double *b, int m,
+                     int odd, int n) {
+  for (int i = 0; i < n * n; i++) {
+    dst[i] = 0.0;
+  }
+  for (int j = odd; j <= m; j += 2) {
+    if (j < 2) {
+      for (int i = 0; i < n; i++) {
+        dst[i * n + i] += b[j];
+      }
+    } else {
+      const double *p = pw[j / 2];
+      for (int i = 0; i < n * n; i++) {
+        dst[i] += b[j] * p[i];
+      }
+    }
+  }
+}
+
+int s21_matrix_exp(matrix_t *A, matrix_t *result) {
+  return s21_matrix_exp_ctx(NULL, A, result);
+}
+
+int s21_matrix_exp_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result) {
+  int err = OK;
+  int n, m = 13, s = 0, level = 4;
+  double *a, *pw[5], *u, *v, *tmp, norm, scale;
+  const double *b = pade_b13;
+  const double *coeffs[] = {pade_b3, pade_b5, pade_b7, pade_b9};
+  int *piv;
+
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows != A->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  n = A->rows;
+  a = s21_workspace(ctx, 8 * (size_t)n * n * sizeof(double) +
+                             (size_t)n * sizeof(int));
+
+  if (a == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  pw[0] = NULL;
+  for (int i = 1; i < 5; i++) {
+    pw[i] = a + i * n * n;
+  }
+  u = a + 5 * n * n;
+  v = u + n * n;
+  tmp = v + n * n;
+  piv = (int *)(tmp + n * n);
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      a[i * n + j] = A->matrix[i][j];
+    }
+  }
+
+  norm = norm1(a, n);
+
+  if (!isfinite(norm)) {
+    s21_workspace_release(ctx, a);
+    err = NONFINITE;
+    return err;
+  }
+
+  for (int i = 0; i < 4 && m == 13; i++) {
+    if (norm <= pade_theta[i]) {
+      m = pade_degrees[i];
+      b = coeffs[i];
+      level = i + 1;
+    }
+  }
+
+  if (m == 13 && norm > pade_theta[4]) {
+    s = (int)ceil(log2(norm / pade_theta[4]));
+    scale = ldexp(1.0, -s);
+    for (int i = 0; i < n * n; i++) {
+      a[i] *= scale;
+    }
+  }
+
+  // even powers A^2, A^4, A^6 and A^8 as far as the degree needs them
+  s21_gemm(n, n, n, a, n, a, n, pw[1], n, ctx->threads);
+  for (int i = 2; i <= (m == 13 ? 3 : level); i++) {
+    s21_gemm(n, n, n, pw[i - 1], n, pw[1], n, pw[i], n, ctx->threads);
+  }
+
+  if (m == 13) {
+    // degree 13 folds the powers above A^6 into one extra multiply each
+    double *pw6 = pw[3];
+    for (int i = 0; i < n * n; i++) {
+      tmp[i] = b[13] * pw6[i] + b[11] * pw[2][i] + b[9] * pw[1][i];
+    }
+    s21_gemm(n, n, n, pw6, n, tmp, n, u, n, ctx->threads);
+    for (int i = 0; i < n * n; i++) {
+      u[i] += b[7] * pw6[i] + b[5] * pw[2][i] + b[3] * pw[1][i];
+    }
+    for (int i = 0; i < n; i++) {
+      u[i * n + i] += b[1];
+    }
+    s21_gemm(n, n, n, a, n, u, n, tmp, n, ctx->threads);
+    swap_buffers(&u, &tmp);
+
+    for (int i = 0; i < n * n; i++) {
+      tmp[i] = b[12] * pw6[i] + b[10] * pw[2][i] + b[8] * pw[1][i];
+    }
+    s21_gemm(n, n, n, pw6, n, tmp, n, v, n, ctx->threads);
+    for (int i = 0; i < n * n; i++) {
+      v[i] += b[6] * pw6[i] + b[4] * pw[2][i] + b[2] * pw[1][i];
+    }
+    for (int i = 0; i < n; i++) {
+      v[i * n + i] += b[0];
+    }
+  } else {
+    pade_sum(tmp, pw, b, m, 1, n);
+    s21_gemm(n, n, n, a, n, tmp, n, u, n, ctx->threads);
+    pade_sum(v, pw, b, m, 0, n);
+  }
+
+  // (V - U) X = V + U, the factorization goes into the free A^4 buffer
+  for (int i = 0; i < n * n; i++) {
+    pw[2][i] = v[i] - u[i];
+    tmp[i] = v[i] + u[i];
+  }
+  err = s21_lu_factor(pw[2], n, n, piv, NULL, ctx->threads);
+
+  if (err == OK) {
+    s21_lu_solve(pw[2], n, n, piv, tmp, n, n, ctx->threads);
+    for (int i = 0; i < s; i++) {
+      s21_gemm(n, n, n, tmp, n, tmp, n, u, n, ctx->threads);
+      swap_buffers(&tmp, &u);
+    }
+    err = copy_out(ctx, tmp, n, result);
+  }
+
+  s21_workspace_release(ctx, a);
+
+  return err;
+}
@@ -1,8 +1,113 @@
-#include "s21_matrix.h"
+#include <float.h>
+
+#include "s21_internal.h"
+
+#define TRANSPOSE_TILE 32
+
+// elements from which transpose writes its result in parallel bands
+#define TRANSPOSE_PARALLEL_MIN (1 << 18)
+
+typedef struct transpose_args {
+  matrix_t *A;
+  matrix_t *result;
+} transpose_args_t;
 
 int s21_create_matrix(int rows, int columns, matrix_t *result) {
+  return s21_create_matrix_ctx(NULL, rows, columns, result);
+}
+
+void s21_remove_matrix(matrix_t *A) { s21_remove_matrix_ctx(NULL, A); }
+
+int s21_eq_matrix(matrix_t *A, matrix_t *B) {
+  return s21_eq_matrix_ctx(NULL, A, B);
+}
+
+int s21_sum_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+  return s21_sum_matrix_ctx(NULL, A, B, result);
+}
+
+int s21_sub_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+  return s21_sub_matrix_ctx(NULL, A, B, result);
+}
+
+int s21_mult_number(matrix_t *A, double number, matrix_t *result) {
+  return s21_mult_number_ctx(NULL, A, number, result);
+}
+
+int s21_mult_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+  return s21_mult_matrix_ctx(NULL, A, B, result);
+}
+
+int s21_transpose(matrix_t *A, matrix_t *result) {
+  return s21_transpose_ctx(NULL, A, result);
+}
+
+int s21_calc_complements(matrix_t *A, matrix_t *result) {
+  return s21_calc_complements_ctx(NULL, A, result);
+}
+
+int s21_determinant(matrix_t *A, double *result) {
+  return s21_determinant_ctx(NULL, A, result);
+}
+
+int s21_inverse_matrix(matrix_t *A, matrix_t *result) {
+  return s21_inverse_matrix_ctx(NULL, A, result);
+}
+
+int s21_copy_matrix(matrix_t *A, matrix_t *result) {
+  return s21_copy_matrix_ctx(NULL, A, result);
+}
+
+const char *s21_backend(void) {
+#ifdef S21_USE_BLAS
+  return "blas";
+#else
+  return "builtin";
+#endif
+}
+
+static size_t matrix_size(int rows, int columns) {
+  return (size_t)rows * sizeof(double *) +
+         (size_t)rows * (size_t)columns * sizeof(double);
+}
+
+// workspace for an n x n lu factorization, one work row and its pivots
+static size_t lu_size(int n) {
+  return (size_t)n * (size_t)(n + 1) * sizeof(double) +
+         (size_t)n * sizeof(int);
+}
+
+static void copy_block(matrix_t *A, double *dst, int skip_row, int skip_col) {
+  int n = 0;
+
+  for (int i = 0; i < A->rows; i++) {
+    if (i == skip_row) {
+      continue;
+    }
+    for (int j = 0; j < A->columns; j++) {
+      if (j != skip_col) {
+        dst[n++] = A->matrix[i][j];
+      }
+    }
+  }
+}
+
+// with check_finite a result that overflowed is removed again
+static int finite_result(s21_context_t *ctx, int err, matrix_t *result) {
+  if (err == OK && ctx->check_finite && s21_check_finite(result) != OK) {
+    s21_remove_matrix_ctx(ctx, result);
+    err = NONFINITE;
+  }
+
+  return err;
+}
+
+int s21_create_matrix_ctx(s21_context_t *ctx, int rows, int columns,
+                          matrix_t *result) {
   int err = OK;
 
+  ctx = s21_resolve_context(ctx);
+
   result->rows = rows;
   result->columns = columns;
 
@@ -11,35 +116,64 @@ int s21_create_matrix(int rows, int columns, matrix_t *result) {
     return err;
   }
 
-  result->matrix =
-      (double **)malloc(result->rows * sizeof(double *) +
-                        result->rows * result->columns * sizeof(double));
+  result->matrix = (double **)ctx->allocator.alloc(
+      matrix_size(rows, columns), ctx->allocator.user);
 
   if (result->matrix == NULL) {
     err = WRONGMAT;
-    free(result->matrix);
   } else {
     result->matrix[0] = (double *)(result->matrix + result->rows);
     for (int i = 1; i < result->rows; i++) {
       result->matrix[i] = result->matrix[0] + i * result->columns;
     }
+    if (ctx->first_touch) {
+      s21_first_touch(result->matrix[0], rows, columns, ctx->threads);
+    }
   }
 
   return err;
 }
 
-void s21_remove_matrix(matrix_t *A) {
+void s21_remove_matrix_ctx(s21_context_t *ctx, matrix_t *A) {
+  ctx = s21_resolve_context(ctx);
+
   if (A->rows > 0 && A->columns > 0) {
     if (A->matrix != NULL) {
-      free(A->matrix);
+      ctx->allocator.release(A->matrix, matrix_size(A->rows, A->columns),
+                             ctx->allocator.user);
     }
   }
 }
 
-int s21_eq_matrix(matrix_t *A, matrix_t *B) {
+int s21_copy_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result) {
+  int err;
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  err = s21_create_matrix_ctx(ctx, A->rows, A->columns, result);
+
+  if (err == OK) {
+    memcpy(result->matrix[0], A->matrix[0],
+           (size_t)A->rows * A->columns * sizeof(double));
+  }
+
+  return err;
+}
+
+int s21_eq_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B) {
   int err = SUCCESS;
   double epsilon = 0.0000001, rounded_a, rounded_b;
 
+  (void)ctx;
+
   if (A->matrix == NULL || B->matrix == NULL) {
     err = WRONGMAT;
     return err;
@@ -70,7 +204,8 @@ int s21_eq_matrix(matrix_t *A, matrix_t *B) {
   return err;
 }
 
-int s21_sum_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+int s21_sum_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                       matrix_t *result) {
   int err;
 
   if (A->matrix == NULL || B->matrix == NULL) {
@@ -94,20 +229,29 @@ int s21_sum_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
     return err;
   }
 
-  err = s21_create_matrix(A->rows, A->columns, result);
+  ctx = s21_resolve_context(ctx);
+  err = s21_finite_inputs(ctx, A, B, 0);
 
   if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, A->rows, A->columns, result);
+  }
+
+  if (err == OK) {
+    unsigned fp = s21_fp_enter(ctx);
     for (int i = 0; i < A->rows; i++) {
       for (int j = 0; j < A->columns; j++) {
         result->matrix[i][j] = A->matrix[i][j] + B->matrix[i][j];
       }
     }
+    s21_fp_leave(fp);
+    err = finite_result(ctx, err, result);
   }
 
   return err;
 }
 
-int s21_sub_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+int s21_sub_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                       matrix_t *result) {
   int err;
 
   if (A->matrix == NULL || B->matrix == NULL) {
@@ -125,20 +269,29 @@ int s21_sub_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
     return err;
   }
 
-  err = s21_create_matrix(A->rows, A->columns, result);
+  ctx = s21_resolve_context(ctx);
+  err = s21_finite_inputs(ctx, A, B, 0);
 
   if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, A->rows, A->columns, result);
+  }
+
+  if (err == OK) {
+    unsigned fp = s21_fp_enter(ctx);
     for (int i = 0; i < A->rows; i++) {
       for (int j = 0; j < A->columns; j++) {
         result->matrix[i][j] = A->matrix[i][j] - B->matrix[i][j];
       }
     }
+    s21_fp_leave(fp);
+    err = finite_result(ctx, err, result);
   }
 
   return err;
 }
 
-int s21_mult_number(matrix_t *A, double number, matrix_t *result) {
+int s21_mult_number_ctx(s21_context_t *ctx, matrix_t *A, double number,
+                        matrix_t *result) {
   int err;
 
   if (A->matrix == NULL) {
@@ -151,22 +304,30 @@ int s21_mult_number(matrix_t *A, double number, matrix_t *result) {
     return err;
   }
 
-  err = s21_create_matrix(A->rows, A->columns, result);
+  ctx = s21_resolve_context(ctx);
+  err = s21_finite_inputs(ctx, A, NULL, 0);
 
   if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, A->rows, A->columns, result);
+  }
+
+  if (err == OK) {
+    unsigned fp = s21_fp_enter(ctx);
     for (int i = 0; i < A->rows; i++) {
       for (int j = 0; j < A->columns; j++) {
         result->matrix[i][j] = A->matrix[i][j] * number;
       }
     }
+    s21_fp_leave(fp);
+    err = finite_result(ctx, err, result);
   }
 
   return err;
 }
 
-int s21_mult_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+int s21_mult_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                        matrix_t *result) {
   int err;
-  double sum;
 
   if (A->matrix == NULL || B->matrix == NULL) {
     err = WRONGMAT;
@@ -183,25 +344,87 @@ int s21_mult_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
     return err;
   }
 
-  err = s21_create_matrix(A->rows, B->columns, result);
+  ctx = s21_resolve_context(ctx);
+  err = s21_finite_inputs(ctx, A, B, 0);
 
   if (err == OK) {
-    for (int i = 0; i < result->rows; i++) {
-      for (int j = 0; j < result->columns; j++) {
-        sum = 0;
-        for (int k = 0; k < A->columns; k++) {
-          sum += A->matrix[i][k] * B->matrix[k][j];
+    err = s21_create_matrix_ctx(ctx, A->rows, B->columns, result);
+  }
+
+  if (err == OK) {
+    size_t size = s21_gemm_accum_size(A->rows, B->columns, A->columns,
+                                      ctx->accumulation);
+    double *work = size > 0 ? s21_workspace(ctx, size) : NULL;
+    if (size > 0 && work == NULL) {
+      s21_remove_matrix_ctx(ctx, result);
+      err = WRONGMAT;
+    } else {
+      unsigned fp = s21_fp_enter(ctx);
+      s21_gemm_accum(A->rows, B->columns, A->columns, A->matrix[0],
+                     A->columns, B->matrix[0], B->columns, result->matrix[0],
+                     result->columns, ctx->threads, ctx->accumulation, work);
+      s21_fp_leave(fp);
+      s21_workspace_release(ctx, work);
+      err = finite_result(ctx, err, result);
+    }
+  }
+
+  return err;
+}
+
+// rows [r0, r1) of the result, in square tiles that keep both the read and
+// the write side in cache
+static void transpose_band(void *arg, int band, int r0, int r1) {
+  const transpose_args_t *t = arg;
+  matrix_t *A = t->A;
+
+  (void)band;
+  for (int i0 = 0; i0 < A->rows; i0 += TRANSPOSE_TILE) {
+    for (int j0 = r0; j0 < r1; j0 += TRANSPOSE_TILE) {
+      int i1 = i0 + TRANSPOSE_TILE < A->rows ? i0 + TRANSPOSE_TILE : A->rows;
+      int j1 = j0 + TRANSPOSE_TILE < r1 ? j0 + TRANSPOSE_TILE : r1;
+      for (int i = i0; i < i1; i++) {
+        for (int j = j0; j < j1; j++) {
+          t->result->matrix[j][i] = A->matrix[i][j];
         }
-        result->matrix[i][j] = sum;
       }
     }
   }
+}
+
+int s21_transpose_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result) {
+  transpose_args_t t = {A, result};
+  int err;
+
+  if (A->matrix == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  ctx = s21_resolve_context(ctx);
+  err = s21_create_matrix_ctx(ctx, A->columns, A->rows, result);
+
+  // result rows go out in the same bands as its first touch
+  if (err == OK && (double)A->rows * A->columns >= TRANSPOSE_PARALLEL_MIN) {
+    s21_parallel_bands(ctx->threads, result->matrix[0], result->rows,
+                       result->columns, transpose_band, &t);
+  } else if (err == OK) {
+    transpose_band(&t, 0, 0, result->rows);
+  }
 
   return err;
 }
 
-int s21_transpose(matrix_t *A, matrix_t *result) {
-  int err;
+int s21_calc_complements_ctx(s21_context_t *ctx, matrix_t *A,
+                             matrix_t *result) {
+  int err, n;
+  double det, *minor;
+  int *piv;
 
   if (A->matrix == NULL) {
     err = WRONGMAT;
@@ -213,30 +436,56 @@ int s21_transpose(matrix_t *A, matrix_t *result) {
     return err;
   }
 
-  err = s21_create_matrix(A->columns, A->rows, result);
+  if (A->rows != A->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  ctx = s21_resolve_context(ctx);
+  err = s21_finite_inputs(ctx, A, NULL, 1);
+
+  if (err != OK) {
+    return err;
+  }
+
+  n = A->rows - 1;
+  minor = s21_workspace(ctx, lu_size(n + 1));
+
+  if (minor == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  piv = (int *)(minor + n * n);
+
+  err = s21_create_matrix_ctx(ctx, A->rows, A->columns, result);
 
   if (err == OK) {
+    unsigned fp = s21_fp_enter(ctx);
     for (int i = 0; i < A->rows; i++) {
       for (int j = 0; j < A->columns; j++) {
-        result->matrix[j][i] = A->matrix[i][j];
+        copy_block(A, minor, i, j);
+        s21_lu_factor(minor, n, n, piv, &det, 1);
+        result->matrix[i][j] = (i + j) % 2 == 0 ? det : -det;
       }
     }
+    s21_fp_leave(fp);
+    err = finite_result(ctx, err, result);
   }
 
+  s21_workspace_release(ctx, minor);
+
   return err;
 }
 
-int s21_calc_complements(matrix_t *A, matrix_t *result) {
-  int err, sub_j, sub_i;
-  double det, complement;
-
-  matrix_t submatrix;
+int s21_determinant_ctx(s21_context_t *ctx, matrix_t *A, double *result) {
+  int err = OK;
+  int n;
+  unsigned fp;
+  double *lu;
+  int *piv;
 
-  err = s21_create_matrix(A->rows, A->columns, result);
-
-  if (err != OK) {
-    return err;
-  }
+  ctx = s21_resolve_context(ctx);
 
   if (A->matrix == NULL) {
     err = WRONGMAT;
@@ -253,45 +502,104 @@ int s21_calc_complements(matrix_t *A, matrix_t *result) {
     return err;
   }
 
-  for (int i = 0; i < A->rows; i++) {
-    for (int j = 0; j < A->columns; j++) {
-      s21_create_matrix(A->rows - 1, A->columns - 1, &submatrix);
+  err = s21_finite_inputs(ctx, A, NULL, 1);
 
-      sub_i = 0;
-      for (int k = 0; k < A->rows; k++) {
-        if (k == i) {
-          continue;
-        }
-        sub_j = 0;
-        for (int l = 0; l < A->columns; l++) {
-          if (l == j) {
-            continue;
-          }
-          submatrix.matrix[sub_i][sub_j] = A->matrix[k][l];
-          sub_j++;
-        }
-        sub_i++;
-      }
+  if (err != OK) {
+    *result = NAN;
+    return err;
+  }
+
+  n = A->rows;
+  lu = s21_workspace(ctx, lu_size(n));
+
+  if (lu == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  piv = (int *)(lu + n * n);
+
+  copy_block(A, lu, -1, -1);
+  fp = s21_fp_enter(ctx);
+  s21_lu_factor(lu, n, n, piv, result, ctx->threads);
+  s21_fp_leave(fp);
+  s21_workspace_release(ctx, lu);
+
+  if (!isfinite(*result)) {
+    err = NONFINITE;
+  }
+
+  return err;
+}
+
+// factors a copy of square A in the workspace, pivots at rounding level of
+// the largest entry mean a singular matrix; the caller releases *lu
+static int factor_checked(s21_context_t *ctx, matrix_t *A, double **lu,
+                          int **piv) {
+  int err = OK;
+  int n = A->rows;
+  double max = 0.0;
+
+  *lu = s21_workspace(ctx, lu_size(n));
 
-      s21_determinant(&submatrix, &det);
+  if (*lu == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
 
-      complement = det * pow(-1, i + j + 2);
+  *piv = (int *)(*lu + n * (n + 1));
 
-      result->matrix[i][j] = complement;
+  err = s21_finite_inputs(ctx, A, NULL, 1);
 
-      s21_remove_matrix(&submatrix);
+  if (err != OK) {
+    return err;
+  }
+
+  copy_block(A, *lu, -1, -1);
+  for (int i = 0; i < n * n; i++) {
+    max = fmax(max, fabs((*lu)[i]));
+  }
+
+  err = s21_lu_factor(*lu, n, n, *piv, NULL, ctx->threads);
+
+  for (int i = 0; i < n && err == OK; i++) {
+    if (fabs((*lu)[i * n + i]) <= n * DBL_EPSILON * max) {
+      err = CALCERR;
     }
   }
 
   return err;
 }
 
-int s21_determinant(matrix_t *A, double *result) {
+// reciprocal condition number in the 1-norm from the computed inverse, the
+// norms take their scratch from ctx once the factorization released it
+static int conditioned(s21_context_t *ctx, matrix_t *A, matrix_t *inverse) {
+  int err = OK;
+  double norm_a, norm_inv;
+
+  if (s21_check_finite(inverse) != OK) {
+    err = NONFINITE;
+    return err;
+  }
+
+  if (s21_norm_matrix_ctx(ctx, A, NORM_ONE, &norm_a) != OK ||
+      s21_norm_matrix_ctx(ctx, inverse, NORM_ONE, &norm_inv) != OK) {
+    err = WRONGMAT;
+  } else if (1.0 / (norm_a * norm_inv) < DBL_EPSILON) {
+    err = ILLCOND;
+  }
+
+  return err;
+}
+
+int s21_inverse_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result) {
   int err = OK;
-  int i, j, k, sign;
-  double det = 0.0;
+  int n;
+  unsigned fp;
+  double *lu;
+  int *piv;
 
-  matrix_t submatrix;
+  ctx = s21_resolve_context(ctx);
 
   if (A->matrix == NULL) {
     err = WRONGMAT;
@@ -308,81 +616,85 @@ int s21_determinant(matrix_t *A, double *result) {
     return err;
   }
 
-  if (A->rows == 1) {
-    *result = A->matrix[0][0];
-  } else if (A->rows == 2) {
-    *result =
-        A->matrix[0][0] * A->matrix[1][1] - A->matrix[0][1] * A->matrix[1][0];
-  } else {
-    err = s21_create_matrix(A->rows - 1, A->columns - 1, &submatrix);
-
-    for (k = 0; k < A->columns; k++) {
-      for (i = 1; i < A->rows; i++) {
-        for (j = 0; j < A->columns; j++) {
-          if (j != k) {
-            submatrix.matrix[i - 1][j < k ? j : j - 1] = A->matrix[i][j];
-          }
-        }
-      }
+  n = A->rows;
+  fp = s21_fp_enter(ctx);
+  err = factor_checked(ctx, A, &lu, &piv);
 
-      if (k % 2 == 0) {
-        sign = 1;
-      } else {
-        sign = -1;
-      }
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, n, n, result);
+  }
 
-      err = s21_determinant(&submatrix, result);
+  if (err == OK) {
+    s21_lu_inverse(lu, n, n, piv, result->matrix[0], lu + n * n,
+                   ctx->threads);
+  }
 
-      if (err != OK) {
-        s21_remove_matrix(&submatrix);
-        break;
-      } else {
-        det += sign * A->matrix[0][k] * (*result);
-      }
-    }
+  s21_workspace_release(ctx, lu);
 
-    if (err == OK) {
-      *result = det;
-      s21_remove_matrix(&submatrix);
+  if (err == OK) {
+    err = conditioned(ctx, A, result);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, result);
     }
   }
 
+  s21_fp_leave(fp);
+
   return err;
 }
 
-int s21_inverse_matrix(matrix_t *A, matrix_t *result) {
+int s21_solve_matrix(matrix_t *A, matrix_t *B, matrix_t *result) {
+  return s21_solve_matrix_ctx(NULL, A, B, result);
+}
+
+int s21_solve_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                         matrix_t *result) {
   int err = OK;
-  double det = 0.0;
+  double *lu;
+  int *piv;
+  unsigned fp;
 
-  if (A->rows <= 0 || A->columns <= 0) {
+  ctx = s21_resolve_context(ctx);
+
+  if (A->matrix == NULL || B->matrix == NULL) {
     err = WRONGMAT;
     return err;
   }
 
-  if (A->rows != A->columns) {
+  if (A->rows <= 0 || A->columns <= 0 || B->rows <= 0 || B->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (A->rows != A->columns || A->rows != B->rows) {
     err = CALCERR;
     return err;
   }
 
-  s21_determinant(A, &det);
+  if (s21_check_finite(B) != OK) {
+    err = NONFINITE;
+    return err;
+  }
 
-  if (det == 0) {
-    err = CALCERR;
-  } else {
-    matrix_t subres;
+  fp = s21_fp_enter(ctx);
+  err = factor_checked(ctx, A, &lu, &piv);
 
-    s21_create_matrix(A->rows, A->columns, &subres);
-    s21_calc_complements(A, &subres);
-    s21_transpose(&subres, result);
+  if (err == OK) {
+    err = s21_create_matrix_ctx(ctx, B->rows, B->columns, result);
+  }
 
-    for (int i = 0; i < A->rows; i++) {
-      for (int j = 0; j < A->columns; j++) {
-        result->matrix[i][j] /= det;
-      }
+  if (err == OK) {
+    copy_block(B, result->matrix[0], -1, -1);
+    s21_lu_solve(lu, A->rows, A->rows, piv, result->matrix[0], B->columns,
+                 B->columns, ctx->threads);
+    if (s21_check_finite(result) != OK) {
+      s21_remove_matrix_ctx(ctx, result);
+      err = NONFINITE;
     }
-
-    s21_remove_matrix(&subres);
   }
 
+  s21_workspace_release(ctx, lu);
+  s21_fp_leave(fp);
+
   return err;
-}
\ No newline at end of file
+}
@@ -5,16 +5,77 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// rows are stored back to back in one block, as laid out by s21_create_matrix
 typedef struct matrix_struct {
   double **matrix;
   int rows;
   int columns;
 } matrix_t;
 
-enum errors { OK, WRONGMAT, CALCERR };
+// contiguous vector, a view from s21_matrix_row shares the matrix storage
+// and is not removed
+typedef struct vector_struct {
+  double *data;
+  int size;
+} vector_t;
+
+// allocator used for matrices and workspace created through a context;
+// release receives the same size that was passed to alloc
+typedef struct s21_allocator {
+  void *(*alloc)(size_t size, void *user);
+  void (*release)(void *ptr, size_t size, void *user);
+  void *user;
+} s21_allocator_t;
+
+// per-caller state: allocator, reusable scratch workspace and thread settings,
+// opaque so new settings do not change the abi; a context must not be used by
+// two threads at once, NULL selects the calling thread's own default context
+typedef struct s21_context s21_context_t;
+
+// inverse and determinant of A kept current through low-rank updates; after
+// every check_interval updates a residual probe refactors when it exceeds
+// tolerance, so does an update whose denominator falls below it; when that
+// update leaves A singular the cache keeps its previous A
+typedef struct s21_inverse_cache {
+  s21_context_t *ctx;
+  matrix_t A;
+  matrix_t inverse;
+  double determinant;
+  double tolerance;
+  int check_interval;
+  int updates;
+  int refactorizations;
+} s21_inverse_cache_t;
+
+// handle of an operation submitted to the internal pool
+typedef struct s21_future s21_future_t;
+
+typedef void (*s21_callback_t)(s21_future_t *future, void *user);
+
+// opaque matrix owned by the library, its layout may change between releases
+// without breaking clients of the shared library
+typedef struct s21_handle s21_handle_t;
+
+// bumped on incompatible changes to the exported functions, together with the
+// shared library's SOVERSION
+#define S21_ABI_VERSION 2
+
+// NONFINITE: nan or inf in the input, or a result that overflowed; ILLCOND:
+// the inverse exists but its reciprocal condition number is below epsilon;
+// determinant, calc_complements, inverse, solve, the matrix functions and the
+// decompositions always check their inputs, inverse and solve their results
+// as well
+enum errors { OK, WRONGMAT, CALCERR, NONFINITE, ILLCOND };
 
 enum eq_errors { FAILURE, SUCCESS };
 
+enum norms { NORM_ONE, NORM_INF, NORM_FRO };
+
+// naive is the plain running sum; pairwise bounds the error growth by log k;
+// kahan carries a Neumaier-style correction; dot2 also corrects every product
+// and is as accurate as summing in twice the precision
+enum accumulations { ACCUM_NAIVE, ACCUM_PAIRWISE, ACCUM_KAHAN, ACCUM_DOT2 };
+
 // main funcs
 int s21_create_matrix(int rows, int columns, matrix_t *result);
 void s21_remove_matrix(matrix_t *A);
@@ -28,4 +89,188 @@ int s21_calc_complements(matrix_t *A, matrix_t *result);
 int s21_determinant(matrix_t *A, double *result);
 int s21_inverse_matrix(matrix_t *A, matrix_t *result);
 
+// new matrix with the same entries, one memcpy of the data block
+int s21_copy_matrix(matrix_t *A, matrix_t *result);
+
+// solves A * X = B for X
+int s21_solve_matrix(matrix_t *A, matrix_t *B, matrix_t *result);
+
+// vector funcs, results go to existing vectors; y = alpha * op(A) * x +
+// beta * y for gemv (op(A) = A) and gemv_t (op(A) = A^T)
+int s21_create_vector(int size, vector_t *result);
+void s21_remove_vector(vector_t *x);
+int s21_matrix_row(matrix_t *A, int row, vector_t *result);
+int s21_dot(vector_t *x, vector_t *y, double *result);
+int s21_axpy(double alpha, vector_t *x, vector_t *y);
+int s21_nrm2(vector_t *x, double *result);
+int s21_gemv(double alpha, matrix_t *A, vector_t *x, double beta,
+             vector_t *y);
+int s21_gemv_t(double alpha, matrix_t *A, vector_t *x, double beta,
+               vector_t *y);
+int s21_norm_matrix(matrix_t *A, int kind, double *result);
+
+// matrix functions, negative powers go through the inverse; pow multiplies
+// under the context's accumulation, exp always sums naively
+int s21_matrix_pow(matrix_t *A, long long k, matrix_t *result);
+int s21_matrix_exp(matrix_t *A, matrix_t *result);
+
+// incremental updates, vectors are n x 1 or 1 x n matrices; the products sum
+// naively whatever the cache context's accumulation
+int s21_inverse_cache_init(s21_context_t *ctx, matrix_t *A,
+                           s21_inverse_cache_t *cache);
+void s21_inverse_cache_remove(s21_inverse_cache_t *cache);
+int s21_inverse_cache_refactor(s21_inverse_cache_t *cache);
+int s21_rank1_update(s21_inverse_cache_t *cache, matrix_t *u, matrix_t *v);
+int s21_rank_update(s21_inverse_cache_t *cache, matrix_t *U, matrix_t *V);
+int s21_row_update(s21_inverse_cache_t *cache, int row, matrix_t *values);
+int s21_column_update(s21_inverse_cache_t *cache, int column,
+                      matrix_t *values);
+
+// decompositions, iterations receives QL steps or Jacobi sweeps and may be
+// NULL; eigen reads the lower triangle of A and returns ascending values with
+// eigenvectors as columns (vectors may be NULL), svd is the thin A = U S V^T
+// with descending singular values, qr needs rows >= columns
+int s21_eigen_symmetric(matrix_t *A, matrix_t *values, matrix_t *vectors,
+                        int *iterations);
+int s21_svd_matrix(matrix_t *A, matrix_t *U, matrix_t *S, matrix_t *V,
+                   int *iterations);
+int s21_qr_matrix(matrix_t *A, matrix_t *Q, matrix_t *R);
+
+// OK when every entry is finite, NONFINITE otherwise, WRONGMAT without a
+// matrix
+int s21_check_finite(matrix_t *A);
+
+// "blas" when built with BLAS=1, "builtin" otherwise
+const char *s21_backend(void);
+
+// context funcs; threads caps how many pool workers a single call may use, 0
+// allows all of them; accumulation picks how mult_matrix, matrix_pow and dot
+// sum their products, one of enum accumulations; flush_denormals runs each call
+// with flush-to-zero and denormals-are-zero set, restoring the caller's mode on
+// return (x86 only); check_finite rejects nan or inf in the inputs and results
+// of the main funcs with NONFINITE; first_touch makes create_matrix zero large
+// matrices in parallel row bands of whole huge pages, each preferably on the
+// pool worker that mult_matrix and transpose later offer the same rows to, so
+// on numa systems most pages land on the node that computes them; the allocator
+// is set before anything is created through the context
+int s21_context_create(s21_context_t **result);
+void s21_context_destroy(s21_context_t *ctx);
+int s21_context_reserve(s21_context_t *ctx, size_t size);
+int s21_context_set_allocator(s21_context_t *ctx, s21_allocator_t allocator);
+int s21_context_set_threads(s21_context_t *ctx, int threads);
+int s21_context_set_accumulation(s21_context_t *ctx, int mode);
+int s21_context_set_flush_denormals(s21_context_t *ctx, int enable);
+int s21_context_set_check_finite(s21_context_t *ctx, int enable);
+int s21_context_set_first_touch(s21_context_t *ctx, int enable);
+
+// the hugepage allocator maps blocks of 2 MiB and more in explicit huge pages
+// when the system reserved them and as transparent huge pages otherwise,
+// smaller blocks come from malloc
+s21_allocator_t s21_hugepage_allocator(void);
+
+// context variants of main funcs, matrices created through a context must be
+// removed through the same context
+int s21_create_matrix_ctx(s21_context_t *ctx, int rows, int columns,
+                          matrix_t *result);
+void s21_remove_matrix_ctx(s21_context_t *ctx, matrix_t *A);
+int s21_eq_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B);
+int s21_sum_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                       matrix_t *result);
+int s21_sub_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                       matrix_t *result);
+int s21_mult_number_ctx(s21_context_t *ctx, matrix_t *A, double number,
+                        matrix_t *result);
+int s21_mult_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                        matrix_t *result);
+int s21_transpose_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result);
+int s21_calc_complements_ctx(s21_context_t *ctx, matrix_t *A,
+                             matrix_t *result);
+int s21_determinant_ctx(s21_context_t *ctx, matrix_t *A, double *result);
+int s21_inverse_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result);
+int s21_copy_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result);
+int s21_solve_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *B,
+                         matrix_t *result);
+int s21_dot_ctx(s21_context_t *ctx, vector_t *x, vector_t *y, double *result);
+int s21_norm_matrix_ctx(s21_context_t *ctx, matrix_t *A, int kind,
+                        double *result);
+int s21_matrix_pow_ctx(s21_context_t *ctx, matrix_t *A, long long k,
+                       matrix_t *result);
+int s21_matrix_exp_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *result);
+int s21_eigen_symmetric_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *values,
+                            matrix_t *vectors, int *iterations);
+int s21_svd_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *U,
+                       matrix_t *S, matrix_t *V, int *iterations);
+int s21_qr_matrix_ctx(s21_context_t *ctx, matrix_t *A, matrix_t *Q,
+                      matrix_t *R);
+
+// async funcs, each op starts once all deps completed and fails with the
+// first failing dep's error; the returned future is released by the caller;
+// ops run on a private copy of ctx's settings and allocator (NULL for the
+// defaults), so ctx may be changed or destroyed once the call returns;
+// shutdown runs every queued op to completion before stopping the pool and
+// waits for sync calls that are using it, it must not race new submissions
+int s21_async_init(int threads);
+void s21_async_shutdown(void);
+s21_future_t *s21_async_sum_matrix(s21_context_t *ctx, matrix_t *A,
+                                   matrix_t *B, matrix_t *result,
+                                   s21_future_t **deps, int ndeps);
+s21_future_t *s21_async_sub_matrix(s21_context_t *ctx, matrix_t *A,
+                                   matrix_t *B, matrix_t *result,
+                                   s21_future_t **deps, int ndeps);
+s21_future_t *s21_async_mult_number(s21_context_t *ctx, matrix_t *A,
+                                    double number, matrix_t *result,
+                                    s21_future_t **deps, int ndeps);
+s21_future_t *s21_async_mult_matrix(s21_context_t *ctx, matrix_t *A,
+                                    matrix_t *B, matrix_t *result,
+                                    s21_future_t **deps, int ndeps);
+s21_future_t *s21_async_transpose(s21_context_t *ctx, matrix_t *A,
+                                  matrix_t *result, s21_future_t **deps,
+                                  int ndeps);
+s21_future_t *s21_async_calc_complements(s21_context_t *ctx, matrix_t *A,
+                                         matrix_t *result, s21_future_t **deps,
+                                         int ndeps);
+s21_future_t *s21_async_determinant(s21_context_t *ctx, matrix_t *A,
+                                    double *result, s21_future_t **deps,
+                                    int ndeps);
+s21_future_t *s21_async_inverse_matrix(s21_context_t *ctx, matrix_t *A,
+                                       matrix_t *result, s21_future_t **deps,
+                                       int ndeps);
+int s21_future_poll(s21_future_t *future);
+int s21_future_wait(s21_future_t *future);
+int s21_future_error(s21_future_t *future);
+int s21_future_then(s21_future_t *future, s21_callback_t callback, void *user);
+void s21_future_release(s21_future_t *future);
+
+// S21_ABI_VERSION of the library actually loaded, to compare with the header
+int s21_abi_version(void);
+
+// handle funcs, results are new handles released by the caller; data exports
+// the row-major buffer for hot loops, rows are stride doubles apart and it
+// stays valid until the handle is released or cloned; clone shares the
+// storage in O(1) and the first set or data on a shared handle copies it,
+// read_data never copies; shared counts the handles on the same storage; a
+// handle may be read or cloned from several threads at once, but not
+// written while another thread uses it
+int s21_handle_create(int rows, int columns, s21_handle_t **result);
+int s21_handle_from_matrix(matrix_t *A, s21_handle_t **result);
+int s21_handle_to_matrix(s21_handle_t *h, matrix_t *result);
+int s21_handle_clone(s21_handle_t *h, s21_handle_t **result);
+int s21_handle_shared(const s21_handle_t *h);
+void s21_handle_release(s21_handle_t *h);
+int s21_handle_rows(const s21_handle_t *h);
+int s21_handle_columns(const s21_handle_t *h);
+int s21_handle_get(const s21_handle_t *h, int row, int column, double *value);
+int s21_handle_set(s21_handle_t *h, int row, int column, double value);
+double *s21_handle_data(s21_handle_t *h, int *stride);
+const double *s21_handle_read_data(const s21_handle_t *h, int *stride);
+int s21_handle_eq(s21_handle_t *A, s21_handle_t *B);
+int s21_handle_sum(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result);
+int s21_handle_sub(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result);
+int s21_handle_mult_number(s21_handle_t *A, double number,
+                           s21_handle_t **result);
+int s21_handle_mult(s21_handle_t *A, s21_handle_t *B, s21_handle_t **result);
+int s21_handle_transpose(s21_handle_t *A, s21_handle_t **result);
+int s21_handle_inverse(s21_handle_t *A, s21_handle_t **result);
+int s21_handle_determinant(s21_handle_t *A, double *result);
+
 #endif  // C6_S21_MATRIX_0_S21_MATRIX_H
\ No newline at end of file
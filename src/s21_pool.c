@@ -0,0 +1,457 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "s21_internal.h"
+
+typedef struct task {
+  s21_task_fn fn;
+  void *arg;
+} task_t;
+
+// owner pushes and pops at the tail, thieves take from the head
+typedef struct deque {
+  pthread_mutex_t lock;
+  task_t *buf;
+  int cap;
+  int head;
+  int tail;
+} deque_t;
+
+// tasks of a parallel loop share one index counter, so at most `threads`
+// participants pull iterations until the range is exhausted; helpers run
+// under the caller's floating-point state
+typedef struct group {
+  s21_range_fn fn;
+  void *arg;
+  int count;
+  unsigned fp_state;
+  atomic_int next;
+  atomic_int active;
+} group_t;
+
+// row bands of s21_parallel_bands; claimed[b] is set by whoever runs band b
+typedef struct band_group {
+  s21_band_fn fn;
+  void *arg;
+  const double *data;
+  int rows;
+  int ld;
+  int bands;
+  atomic_int claimed[BAND_MAX];
+} band_group_t;
+
+typedef struct pool {
+  pthread_t *threads;
+  deque_t *queues;
+  int size;
+  atomic_int pending;
+  atomic_int stop;
+  atomic_uint next;
+  pthread_mutex_t sleep_lock;
+  pthread_cond_t wake;
+  int sleepers;
+} pool_t;
+
+static pool_t pool;
+static atomic_int pool_ready = 0;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// callers inside parallel_for or help that touch the queues; stop closes the
+// pool to new users and waits for the current ones before tearing it down
+static atomic_int pool_users = 0;
+static atomic_int pool_closing = 0;
+
+static _Thread_local int worker_id = -1;
+
+static int deque_push(deque_t *q, task_t task) {
+  int err = OK;
+
+  pthread_mutex_lock(&q->lock);
+
+  if (q->tail - q->head == q->cap) {
+    int cap = q->cap ? q->cap * 2 : 64;
+    task_t *buf = malloc(cap * sizeof(task_t));
+
+    if (buf == NULL) {
+      err = WRONGMAT;
+    } else {
+      for (int i = q->head; i < q->tail; i++) {
+        buf[i - q->head] = q->buf[i % q->cap];
+      }
+      free(q->buf);
+      q->tail -= q->head;
+      q->head = 0;
+      q->buf = buf;
+      q->cap = cap;
+    }
+  }
+
+  if (err == OK) {
+    q->buf[q->tail % q->cap] = task;
+    q->tail++;
+  }
+
+  pthread_mutex_unlock(&q->lock);
+
+  return err;
+}
+
+static int deque_take(deque_t *q, task_t *task, int steal) {
+  int found = 0;
+
+  pthread_mutex_lock(&q->lock);
+
+  if (q->tail > q->head) {
+    if (steal) {
+      *task = q->buf[q->head % q->cap];
+      q->head++;
+    } else {
+      q->tail--;
+      *task = q->buf[q->tail % q->cap];
+    }
+    found = 1;
+  }
+
+  pthread_mutex_unlock(&q->lock);
+
+  return found;
+}
+
+static int find_task(int self, task_t *task) {
+  int found = 0;
+
+  if (self >= 0) {
+    found = deque_take(&pool.queues[self], task, 0);
+  }
+
+  for (int i = 1; i <= pool.size && !found; i++) {
+    int victim = (self + i + pool.size) % pool.size;
+    if (victim != self) {
+      found = deque_take(&pool.queues[victim], task, 1);
+    }
+  }
+
+  if (found) {
+    atomic_fetch_sub(&pool.pending, 1);
+  }
+
+  return found;
+}
+
+// on stop the workers drain the queues first, a task that is still running
+// may queue dependents and its worker picks them up before leaving
+static void *worker_main(void *arg) {
+  task_t task;
+  int done = 0;
+
+  worker_id = (int)(size_t)arg;
+
+  while (!done) {
+    if (find_task(worker_id, &task)) {
+      task.fn(task.arg);
+    } else {
+      pthread_mutex_lock(&pool.sleep_lock);
+      while (atomic_load(&pool.pending) == 0 && !atomic_load(&pool.stop)) {
+        pool.sleepers++;
+        pthread_cond_wait(&pool.wake, &pool.sleep_lock);
+        pool.sleepers--;
+      }
+      done = atomic_load(&pool.stop) && atomic_load(&pool.pending) == 0;
+      pthread_mutex_unlock(&pool.sleep_lock);
+    }
+  }
+
+  return NULL;
+}
+
+static int pool_enter(void) {
+  int entered = 1;
+
+  atomic_fetch_add(&pool_users, 1);
+  if (!atomic_load(&pool_ready) || atomic_load(&pool_closing)) {
+    atomic_fetch_sub(&pool_users, 1);
+    entered = 0;
+  }
+
+  return entered;
+}
+
+static void pool_leave(void) { atomic_fetch_sub(&pool_users, 1); }
+
+static int auto_threads(void) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return cpus > 0 ? (int)cpus : 1;
+}
+
+int s21_pool_start(int threads) {
+  int err = OK;
+
+  pthread_mutex_lock(&pool_lock);
+
+  if (!atomic_load(&pool_ready)) {
+    pool.size = threads > 0 ? threads : auto_threads();
+    pool.threads = calloc(pool.size, sizeof(pthread_t));
+    pool.queues = calloc(pool.size, sizeof(deque_t));
+    atomic_store(&pool.pending, 0);
+    atomic_store(&pool.stop, 0);
+    atomic_store(&pool.next, 0);
+    pool.sleepers = 0;
+
+    if (pool.threads == NULL || pool.queues == NULL) {
+      free(pool.threads);
+      free(pool.queues);
+      err = WRONGMAT;
+    } else {
+      pthread_mutex_init(&pool.sleep_lock, NULL);
+      pthread_cond_init(&pool.wake, NULL);
+      for (int i = 0; i < pool.size; i++) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+      }
+      for (int i = 0; i < pool.size; i++) {
+        pthread_create(&pool.threads[i], NULL, worker_main, (void *)(size_t)i);
+      }
+      atomic_store(&pool_ready, 1);
+    }
+  }
+
+  pthread_mutex_unlock(&pool_lock);
+
+  return err;
+}
+
+void s21_pool_stop(void) {
+  pthread_mutex_lock(&pool_lock);
+
+  if (atomic_load(&pool_ready)) {
+    atomic_store(&pool_closing, 1);
+    while (atomic_load(&pool_users) > 0) {
+      sched_yield();
+    }
+
+    pthread_mutex_lock(&pool.sleep_lock);
+    atomic_store(&pool.stop, 1);
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.sleep_lock);
+
+    for (int i = 0; i < pool.size; i++) {
+      pthread_join(pool.threads[i], NULL);
+    }
+    for (int i = 0; i < pool.size; i++) {
+      pthread_mutex_destroy(&pool.queues[i].lock);
+      free(pool.queues[i].buf);
+    }
+    pthread_mutex_destroy(&pool.sleep_lock);
+    pthread_cond_destroy(&pool.wake);
+    free(pool.threads);
+    free(pool.queues);
+    atomic_store(&pool_ready, 0);
+    atomic_store(&pool_closing, 0);
+  }
+
+  pthread_mutex_unlock(&pool_lock);
+}
+
+int s21_pool_size(void) {
+  return atomic_load(&pool_ready) || s21_pool_start(0) == OK ? pool.size : 1;
+}
+
+int s21_pool_submit(s21_task_fn fn, void *arg) {
+  int err = OK, target;
+  task_t task = {fn, arg};
+
+  if (!atomic_load(&pool_ready)) {
+    err = s21_pool_start(0);
+  }
+
+  if (err == OK) {
+    target = worker_id >= 0 ? worker_id
+                            : (int)(atomic_fetch_add(&pool.next, 1) %
+                                    (unsigned)pool.size);
+    atomic_fetch_add(&pool.pending, 1);
+    err = deque_push(&pool.queues[target], task);
+    if (err != OK) {
+      atomic_fetch_sub(&pool.pending, 1);
+    }
+  }
+
+  if (err == OK) {
+    pthread_mutex_lock(&pool.sleep_lock);
+    if (pool.sleepers > 0) {
+      pthread_cond_signal(&pool.wake);
+    }
+    pthread_mutex_unlock(&pool.sleep_lock);
+  }
+
+  return err;
+}
+
+// drops the queued copies of one task, returns how many were removed
+static int pool_revoke(s21_task_fn fn, void *arg) {
+  int removed = 0;
+
+  for (int v = 0; v < pool.size; v++) {
+    deque_t *q = &pool.queues[v];
+    int kept;
+    pthread_mutex_lock(&q->lock);
+    kept = q->head;
+    for (int i = q->head; i < q->tail; i++) {
+      task_t task = q->buf[i % q->cap];
+      if (task.fn == fn && task.arg == arg) {
+        removed++;
+      } else {
+        q->buf[kept++ % q->cap] = task;
+      }
+    }
+    q->tail = kept;
+    pthread_mutex_unlock(&q->lock);
+  }
+
+  atomic_fetch_sub(&pool.pending, removed);
+
+  return removed;
+}
+
+int s21_pool_help(void) {
+  task_t task;
+  int found = 0;
+
+  if (pool_enter()) {
+    found = find_task(worker_id, &task);
+    if (found) {
+      task.fn(task.arg);
+    }
+    pool_leave();
+  }
+
+  return found;
+}
+
+static void group_drain(group_t *group) {
+  int index;
+
+  while ((index = atomic_fetch_add(&group->next, 1)) < group->count) {
+    group->fn(group->arg, index);
+  }
+}
+
+static void group_task(void *arg) {
+  group_t *group = arg;
+  unsigned saved = s21_fp_state();
+
+  s21_fp_restore(group->fp_state);
+  group_drain(group);
+  s21_fp_restore(saved);
+  atomic_fetch_sub(&group->active, 1);
+}
+
+// a closing pool runs the loop on the caller alone
+void s21_parallel_for(int threads, int count, s21_range_fn fn, void *arg) {
+  group_t group;
+  int helpers, entered = 0;
+
+  group.fn = fn;
+  group.arg = arg;
+  group.count = count;
+  group.fp_state = s21_fp_state();
+  atomic_init(&group.next, 0);
+  atomic_init(&group.active, 0);
+
+  if (threads <= 0) {
+    threads = s21_pool_size();
+  }
+  helpers = (threads < count ? threads : count) - 1;
+  if (helpers > 0) {
+    entered = pool_enter();
+    helpers = entered ? helpers : 0;
+  }
+
+  for (int i = 0; i < helpers; i++) {
+    atomic_fetch_add(&group.active, 1);
+    if (s21_pool_submit(group_task, &group) != OK) {
+      atomic_fetch_sub(&group.active, 1);
+      break;
+    }
+  }
+
+  group_drain(&group);
+
+  // every index is taken, so helpers still queued have nothing to do; the
+  // caller only waits for the ones already running and never picks up
+  // unrelated tasks, which would run on its thread in the middle of its own
+  // kernel and reuse that thread's default context
+  if (atomic_load(&group.active) > 0) {
+    atomic_fetch_sub(&group.active, pool_revoke(group_task, &group));
+  }
+  while (atomic_load(&group.active) > 0) {
+    sched_yield();
+  }
+
+  if (entered) {
+    pool_leave();
+  }
+}
+
+static int claim_band(band_group_t *group, int band) {
+  return !atomic_exchange(&group->claimed[band], 1);
+}
+
+// every call runs one band: worker b takes band b if it has not started,
+// anyone else the highest band still free, so idle workers find their own
+// band first while a busy one never holds the loop up
+static void band_task(void *arg, int index) {
+  band_group_t *group = arg;
+  int band = worker_id >= 0 && worker_id < group->bands ? worker_id : -1;
+  int r0, r1;
+
+  (void)index;
+  if (band < 0 || !claim_band(group, band)) {
+    band = group->bands - 1;
+    while (!claim_band(group, band)) {
+      band--;
+    }
+  }
+
+  r0 = s21_band_start(group->data, group->rows, group->ld, group->bands,
+                      band);
+  r1 = s21_band_start(group->data, group->rows, group->ld, group->bands,
+                      band + 1);
+  if (r1 > r0) {
+    group->fn(group->arg, band, r0, r1);
+  }
+}
+
+// the bands only depend on threads, the pool size and the rows, so the same
+// matrix is cut the same way from its first touch on; bands are claimed like
+// the indices of parallel_for, the first-touch worker is just the preference
+void s21_parallel_bands(int threads, const double *data, int rows, int ld,
+                        s21_band_fn fn, void *arg) {
+  band_group_t group;
+  int size = s21_pool_size();
+  int bands = threads > 0 && threads < size ? threads : size;
+
+  if (bands > (rows + BAND_ROWS - 1) / BAND_ROWS) {
+    bands = (rows + BAND_ROWS - 1) / BAND_ROWS;
+  }
+  bands = bands < BAND_MAX ? bands : BAND_MAX;
+
+  group.fn = fn;
+  group.arg = arg;
+  group.data = data;
+  group.rows = rows;
+  group.ld = ld;
+  group.bands = bands;
+  for (int band = 0; band < bands; band++) {
+    atomic_init(&group.claimed[band], 0);
+  }
+
+  if (bands > 1) {
+    s21_parallel_for(bands, bands, band_task, &group);
+  } else {
+    fn(arg, 0, 0, rows);
+  }
+}
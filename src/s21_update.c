@@ -0,0 +1,353 @@
+#include "s21_internal.h"
+
+// defaults for the drift probe and the near-singular update guard
+#define CACHE_TOLERANCE 1e-8
+#define CACHE_CHECK_INTERVAL 16
+
+// outcomes of an update: applied, applied but the probe asks for a
+// refactorization, or too close to singular to apply incrementally
+#define UPDATE_DONE 0
+#define UPDATE_DRIFTED 1
+#define UPDATE_UNSTABLE 2
+
+static int vector_length(matrix_t *A) {
+  int n = -1;
+
+  if (A->matrix != NULL && A->rows > 0 && A->columns > 0 &&
+      (A->rows == 1 || A->columns == 1)) {
+    n = A->rows * A->columns;
+  }
+
+  return n;
+}
+
+// inverts next into the cache and makes it the cached A, or frees next and
+// leaves the cache untouched when it is singular
+static int refactor_from(s21_inverse_cache_t *cache, matrix_t *next) {
+  int err;
+  matrix_t inverse;
+  double det;
+
+  err = s21_inverse_matrix_ctx(cache->ctx, next, &inverse);
+
+  if (err == OK) {
+    s21_determinant_ctx(cache->ctx, next, &det);
+    s21_remove_matrix_ctx(cache->ctx, &cache->inverse);
+    cache->inverse = inverse;
+    cache->determinant = det;
+    cache->updates = 0;
+    cache->refactorizations++;
+  }
+
+  if (next != &cache->A) {
+    if (err == OK) {
+      s21_remove_matrix_ctx(cache->ctx, &cache->A);
+      cache->A = *next;
+    } else {
+      s21_remove_matrix_ctx(cache->ctx, next);
+    }
+  }
+
+  return err;
+}
+
+int s21_inverse_cache_refactor(s21_inverse_cache_t *cache) {
+  return refactor_from(cache, &cache->A);
+}
+
+int s21_inverse_cache_init(s21_context_t *ctx, matrix_t *A,
+                           s21_inverse_cache_t *cache) {
+  int err;
+
+  cache->ctx = ctx;
+  cache->tolerance = CACHE_TOLERANCE;
+  cache->check_interval = CACHE_CHECK_INTERVAL;
+  cache->updates = 0;
+  cache->refactorizations = 0;
+
+  err = s21_inverse_matrix_ctx(ctx, A, &cache->inverse);
+
+  if (err == OK) {
+    s21_determinant_ctx(ctx, A, &cache->determinant);
+    err = s21_create_matrix_ctx(ctx, A->rows, A->columns, &cache->A);
+    if (err != OK) {
+      s21_remove_matrix_ctx(ctx, &cache->inverse);
+    }
+  }
+
+  if (err == OK) {
+    for (int i = 0; i < A->rows; i++) {
+      for (int j = 0; j < A->columns; j++) {
+        cache->A.matrix[i][j] = A->matrix[i][j];
+      }
+    }
+  }
+
+  return err;
+}
+
+void s21_inverse_cache_remove(s21_inverse_cache_t *cache) {
+  s21_remove_matrix_ctx(cache->ctx, &cache->A);
+  s21_remove_matrix_ctx(cache->ctx, &cache->inverse);
+}
+
+// ||A (A^-1 x) - x|| / ||x|| for a fixed probe x costs two matrix-vector
+// products and catches an inverse that drifted away from A
+static int drifted(s21_inverse_cache_t *cache, double *y, double *x) {
+  int n = cache->A.rows;
+  double residual = 0.0, sum;
+
+  // entries of x lie in [1, 3], so the absolute residual is already relative
+  for (int i = 0; i < n; i++) {
+    x[i] = 1.0 + i % 3;
+  }
+  s21_gemm(n, 1, n, cache->inverse.matrix[0], n, x, 1, y, 1, 1);
+
+  for (int i = 0; i < n; i++) {
+    sum = -x[i];
+    for (int j = 0; j < n; j++) {
+      sum += cache->A.matrix[i][j] * y[j];
+    }
+    residual = fmax(residual, fabs(sum));
+  }
+
+  return !(residual <= cache->tolerance);
+}
+
+// A += u v^T, A^-1 -= (A^-1 u)(v^T A^-1) / (1 + v^T A^-1 u) and the
+// determinant picks up the same denominator; an unstable update leaves the
+// cache as it was for finish_update to refactor
+static int rank1(s21_inverse_cache_t *cache, const double *u, const double *v,
+                 double *ws) {
+  int n = cache->A.rows;
+  double *y = ws, *z = ws + n, t = 0.0, denom;
+  double **inv = cache->inverse.matrix, **a = cache->A.matrix;
+
+  s21_gemm(n, 1, n, inv[0], n, u, 1, y, 1, 1);
+  s21_gemm(1, n, n, v, n, inv[0], n, z, n, 1);
+
+  for (int i = 0; i < n; i++) {
+    t += v[i] * y[i];
+  }
+  denom = 1.0 + t;
+
+  if (!(fabs(denom) > cache->tolerance * (1.0 + fabs(t)))) {
+    return UPDATE_UNSTABLE;
+  }
+
+  for (int i = 0; i < n; i++) {
+    double yi = y[i] / denom;
+    for (int j = 0; j < n; j++) {
+      a[i][j] += u[i] * v[j];
+      inv[i][j] -= yi * z[j];
+    }
+  }
+  cache->determinant *= denom;
+  cache->updates++;
+
+  if (cache->check_interval > 0 &&
+      cache->updates % cache->check_interval == 0 && drifted(cache, y, z)) {
+    return UPDATE_DRIFTED;
+  }
+
+  return UPDATE_DONE;
+}
+
+// releases the workspace, then refactors as the outcome asks; an unstable
+// update of A by u vt (n x k and k x n, possibly in the workspace) is
+// refactored from a copy, so the cache keeps its state if that fails
+static int finish_update(s21_inverse_cache_t *cache, double *ws, int outcome,
+                         const double *u, const double *vt, int k) {
+  int err = OK;
+  int n = cache->A.rows;
+  matrix_t next;
+
+  if (outcome == UPDATE_UNSTABLE) {
+    err = s21_create_matrix_ctx(cache->ctx, n, n, &next);
+    for (int i = 0; i < n && err == OK; i++) {
+      for (int j = 0; j < n; j++) {
+        double sum = cache->A.matrix[i][j];
+        for (int p = 0; p < k; p++) {
+          sum += u[i * k + p] * vt[p * n + j];
+        }
+        next.matrix[i][j] = sum;
+      }
+    }
+  }
+
+  s21_workspace_release(cache->ctx, ws);
+
+  if (err == OK && outcome == UPDATE_UNSTABLE) {
+    err = refactor_from(cache, &next);
+  } else if (err == OK && outcome == UPDATE_DRIFTED) {
+    err = s21_inverse_cache_refactor(cache);
+  }
+
+  return err;
+}
+
+int s21_rank1_update(s21_inverse_cache_t *cache, matrix_t *u, matrix_t *v) {
+  int err = OK;
+  int n = cache->A.rows;
+  double *ws;
+
+  if (vector_length(u) != n || vector_length(v) != n) {
+    err = vector_length(u) < 0 || vector_length(v) < 0 ? WRONGMAT : CALCERR;
+    return err;
+  }
+
+  ws = s21_workspace(cache->ctx, 2 * (size_t)n * sizeof(double));
+
+  if (ws == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  return finish_update(cache, ws, rank1(cache, u->matrix[0], v->matrix[0], ws),
+                       u->matrix[0], v->matrix[0], 1);
+}
+
+int s21_row_update(s21_inverse_cache_t *cache, int row, matrix_t *values) {
+  int err = OK;
+  int n = cache->A.rows;
+  double *ws;
+
+  if (vector_length(values) < 0 || row < 0 || row >= n) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (vector_length(values) != n) {
+    err = CALCERR;
+    return err;
+  }
+
+  ws = s21_workspace(cache->ctx, 4 * (size_t)n * sizeof(double));
+
+  if (ws == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  for (int i = 0; i < n; i++) {
+    ws[2 * n + i] = i == row;
+    ws[3 * n + i] = values->matrix[0][i] - cache->A.matrix[row][i];
+  }
+
+  return finish_update(cache, ws, rank1(cache, ws + 2 * n, ws + 3 * n, ws),
+                       ws + 2 * n, ws + 3 * n, 1);
+}
+
+int s21_column_update(s21_inverse_cache_t *cache, int column,
+                      matrix_t *values) {
+  int err = OK;
+  int n = cache->A.rows;
+  double *ws;
+
+  if (vector_length(values) < 0 || column < 0 || column >= n) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (vector_length(values) != n) {
+    err = CALCERR;
+    return err;
+  }
+
+  ws = s21_workspace(cache->ctx, 4 * (size_t)n * sizeof(double));
+
+  if (ws == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  for (int i = 0; i < n; i++) {
+    ws[2 * n + i] = values->matrix[0][i] - cache->A.matrix[i][column];
+    ws[3 * n + i] = i == column;
+  }
+
+  return finish_update(cache, ws, rank1(cache, ws + 2 * n, ws + 3 * n, ws),
+                       ws + 2 * n, ws + 3 * n, 1);
+}
+
+// woodbury: A += U V^T, with S = I + V^T A^-1 U the inverse loses
+// (A^-1 U) S^-1 (V^T A^-1) and the determinant gains det(S)
+int s21_rank_update(s21_inverse_cache_t *cache, matrix_t *U, matrix_t *V) {
+  int err = OK;
+  int n = cache->A.rows, k, unstable = 0, outcome = UPDATE_DONE;
+  double *y, *vt, *z, *s, *tmp, det, max = 0.0;
+  int *piv;
+
+  if (U->matrix == NULL || V->matrix == NULL || U->rows <= 0 ||
+      U->columns <= 0 || V->rows <= 0 || V->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (U->rows != n || V->rows != n || U->columns != V->columns) {
+    err = CALCERR;
+    return err;
+  }
+
+  k = U->columns;
+  y = s21_workspace(cache->ctx,
+                    ((size_t)n * n + 3 * (size_t)n * k + (size_t)k * k) *
+                            sizeof(double) +
+                        (size_t)k * sizeof(int));
+
+  if (y == NULL) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  vt = y + n * k;
+  z = vt + k * n;
+  s = z + k * n;
+  tmp = s + k * k;
+  piv = (int *)(tmp + n * n);
+
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < k; j++) {
+      vt[j * n + i] = V->matrix[i][j];
+    }
+  }
+
+  s21_gemm(n, k, n, cache->inverse.matrix[0], n, U->matrix[0], k, y, k, 1);
+  s21_gemm(k, n, n, vt, n, cache->inverse.matrix[0], n, z, n, 1);
+  s21_gemm(k, k, n, vt, n, y, k, s, k, 1);
+  for (int i = 0; i < k; i++) {
+    s[i * k + i] += 1.0;
+  }
+  for (int i = 0; i < k * k; i++) {
+    max = fmax(max, fabs(s[i]));
+  }
+
+  s21_lu_factor(s, k, k, piv, &det, 1);
+  for (int i = 0; i < k; i++) {
+    unstable |= !(fabs(s[i * k + i]) > cache->tolerance * max);
+  }
+
+  if (unstable) {
+    return finish_update(cache, y, UPDATE_UNSTABLE, U->matrix[0], vt, k);
+  }
+
+  s21_gemm(n, n, k, U->matrix[0], k, vt, n, tmp, n, 1);
+  for (int i = 0; i < n * n; i++) {
+    cache->A.matrix[0][i] += tmp[i];
+  }
+
+  s21_lu_solve(s, k, k, piv, z, n, n, 1);
+  s21_gemm(n, n, k, y, k, z, n, tmp, n, 1);
+  for (int i = 0; i < n * n; i++) {
+    cache->inverse.matrix[0][i] -= tmp[i];
+  }
+  cache->determinant *= det;
+  cache->updates++;
+
+  if (cache->check_interval > 0 &&
+      cache->updates % cache->check_interval == 0 && drifted(cache, y, z)) {
+    outcome = UPDATE_DRIFTED;
+  }
+
+  return finish_update(cache, y, outcome, NULL, NULL, 0);
+}
@@ -0,0 +1,322 @@
+#include <string.h>
+
+#include "s21_internal.h"
+
+// pairwise recursion stops at blocks this long
+#define PAIRWISE_BLOCK 128
+
+double s21_dot_kernel(const double *x, const double *y, int n) {
+  v4d acc0 = {0}, acc1 = {0}, a, b;
+  double sum;
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    LOAD4(a, x + i);
+    LOAD4(b, y + i);
+    acc0 += a * b;
+    LOAD4(a, x + i + 4);
+    LOAD4(b, y + i + 4);
+    acc1 += a * b;
+  }
+  acc0 += acc1;
+  sum = (acc0[0] + acc0[1]) + (acc0[2] + acc0[3]);
+  for (; i < n; i++) {
+    sum += x[i] * y[i];
+  }
+
+  return sum;
+}
+
+static double dot_pairwise(const double *x, const double *y, int n) {
+  double sum;
+
+  if (n <= PAIRWISE_BLOCK) {
+    sum = s21_dot_kernel(x, y, n);
+  } else {
+    int half = n / 8 * 4;
+    sum = dot_pairwise(x, y, half) + dot_pairwise(x + half, y + half, n - half);
+  }
+
+  return sum;
+}
+
+// each lane keeps a running sum and compensation, dot2 also compensates the
+// products; the lanes are folded the same way at the end
+static double dot_compensated(const double *x, const double *y, int n,
+                              int exact) {
+  v4d s = {0}, e = {0}, a, b, p;
+  double sum = 0.0, err = 0.0;
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    LOAD4(a, x + i);
+    LOAD4(b, y + i);
+    p = a * b;
+    if (exact) {
+      TWO_PROD_ERR(e, a, b, p);
+    }
+    TWO_SUM(s, e, p);
+  }
+  for (int l = 0; l < 4; l++) {
+    TWO_SUM(sum, err, s[l]);
+    err += e[l];
+  }
+  for (; i < n; i++) {
+    double pi = x[i] * y[i];
+    if (exact) {
+      TWO_PROD_ERR(err, x[i], y[i], pi);
+    }
+    TWO_SUM(sum, err, pi);
+  }
+
+  return sum + err;
+}
+
+double s21_dot_accum(const double *x, const double *y, int n, int mode) {
+  double sum;
+
+  if (mode == ACCUM_PAIRWISE) {
+    sum = dot_pairwise(x, y, n);
+  } else if (mode == ACCUM_KAHAN || mode == ACCUM_DOT2) {
+    sum = dot_compensated(x, y, n, mode == ACCUM_DOT2);
+  } else {
+    sum = s21_dot_kernel(x, y, n);
+  }
+
+  return sum;
+}
+
+void s21_axpy_kernel(double alpha, const double *x, double *y, int n) {
+  v4d scale = {alpha, alpha, alpha, alpha}, a, b;
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    LOAD4(a, x + i);
+    LOAD4(b, y + i);
+    b += scale * a;
+    STORE4(y + i, b);
+  }
+  for (; i < n; i++) {
+    y[i] += alpha * x[i];
+  }
+}
+
+// plain sum of squares first, rescaled by the largest entry only when that
+// overflows or underflows
+double s21_nrm2_kernel(const double *x, int n) {
+  double sum = s21_dot_kernel(x, x, n), max = 0.0;
+
+  if (isinf(sum) || sum < 1e-290) {
+    for (int i = 0; i < n; i++) {
+      max = fmax(max, fabs(x[i]));
+    }
+    if (max > 0.0 && isfinite(max)) {
+      sum = 0.0;
+      for (int i = 0; i < n; i++) {
+        sum += (x[i] / max) * (x[i] / max);
+      }
+      return max * sqrt(sum);
+    }
+  }
+
+  return sqrt(sum);
+}
+
+int s21_create_vector(int size, vector_t *result) {
+  int err = OK;
+
+  result->size = size;
+
+  if (size <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  result->data = calloc(size, sizeof(double));
+
+  if (result->data == NULL) {
+    err = WRONGMAT;
+  }
+
+  return err;
+}
+
+void s21_remove_vector(vector_t *x) {
+  if (x->size > 0 && x->data != NULL) {
+    free(x->data);
+    x->data = NULL;
+  }
+}
+
+int s21_matrix_row(matrix_t *A, int row, vector_t *result) {
+  int err = OK;
+
+  if (A->matrix == NULL || A->rows <= 0 || A->columns <= 0 || row < 0 ||
+      row >= A->rows) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  result->data = A->matrix[row];
+  result->size = A->columns;
+
+  return err;
+}
+
+static double max_or_nan(double a, double b) {
+  return isnan(a) || a > b ? a : b;
+}
+
+static int valid_vector(vector_t *x) { return x->data != NULL && x->size > 0; }
+
+int s21_dot(vector_t *x, vector_t *y, double *result) {
+  return s21_dot_ctx(NULL, x, y, result);
+}
+
+int s21_dot_ctx(s21_context_t *ctx, vector_t *x, vector_t *y,
+                double *result) {
+  int err = OK;
+
+  if (!valid_vector(x) || !valid_vector(y)) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (x->size != y->size) {
+    err = CALCERR;
+    return err;
+  }
+
+  ctx = s21_resolve_context(ctx);
+  *result = s21_dot_accum(x->data, y->data, x->size, ctx->accumulation);
+
+  return err;
+}
+
+int s21_axpy(double alpha, vector_t *x, vector_t *y) {
+  int err = OK;
+
+  if (!valid_vector(x) || !valid_vector(y)) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (x->size != y->size) {
+    err = CALCERR;
+    return err;
+  }
+
+  s21_axpy_kernel(alpha, x->data, y->data, x->size);
+
+  return err;
+}
+
+int s21_nrm2(vector_t *x, double *result) {
+  int err = OK;
+
+  if (!valid_vector(x)) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  *result = s21_nrm2_kernel(x->data, x->size);
+
+  return err;
+}
+
+static int check_gemv(matrix_t *A, vector_t *x, vector_t *y, int in, int out) {
+  int err = OK;
+
+  if (A->matrix == NULL || A->rows <= 0 || A->columns <= 0 ||
+      !valid_vector(x) || !valid_vector(y)) {
+    err = WRONGMAT;
+  } else if (x->size != in || y->size != out || x->data == y->data) {
+    err = CALCERR;
+  }
+
+  return err;
+}
+
+int s21_gemv(double alpha, matrix_t *A, vector_t *x, double beta,
+             vector_t *y) {
+  int err = check_gemv(A, x, y, A->columns, A->rows);
+
+  if (err == OK) {
+    for (int i = 0; i < A->rows; i++) {
+      double ax = s21_dot_kernel(A->matrix[i], x->data, A->columns);
+      y->data[i] = beta == 0.0 ? alpha * ax : alpha * ax + beta * y->data[i];
+    }
+  }
+
+  return err;
+}
+
+int s21_gemv_t(double alpha, matrix_t *A, vector_t *x, double beta,
+               vector_t *y) {
+  int err = check_gemv(A, x, y, A->rows, A->columns);
+
+  // rows of A are streamed once, each scaled into y
+  if (err == OK) {
+    for (int j = 0; j < A->columns; j++) {
+      y->data[j] = beta == 0.0 ? 0.0 : beta * y->data[j];
+    }
+    for (int i = 0; i < A->rows; i++) {
+      s21_axpy_kernel(alpha * x->data[i], A->matrix[i], y->data, A->columns);
+    }
+  }
+
+  return err;
+}
+
+int s21_norm_matrix(matrix_t *A, int kind, double *result) {
+  return s21_norm_matrix_ctx(NULL, A, kind, result);
+}
+
+int s21_norm_matrix_ctx(s21_context_t *ctx, matrix_t *A, int kind,
+                        double *result) {
+  int err = OK;
+  double norm = 0.0, *sums;
+
+  if (A->matrix == NULL || A->rows <= 0 || A->columns <= 0) {
+    err = WRONGMAT;
+    return err;
+  }
+
+  if (kind == NORM_FRO) {
+    norm = s21_nrm2_kernel(A->matrix[0], A->rows * A->columns);
+  } else if (kind == NORM_INF) {
+    for (int i = 0; i < A->rows; i++) {
+      double sum = 0.0;
+      for (int j = 0; j < A->columns; j++) {
+        sum += fabs(A->matrix[i][j]);
+      }
+      norm = max_or_nan(sum, norm);
+    }
+  } else if (kind == NORM_ONE) {
+    sums = s21_workspace(ctx, (size_t)A->columns * sizeof(double));
+    if (sums == NULL) {
+      err = WRONGMAT;
+      return err;
+    }
+    for (int j = 0; j < A->columns; j++) {
+      sums[j] = 0.0;
+    }
+    for (int i = 0; i < A->rows; i++) {
+      for (int j = 0; j < A->columns; j++) {
+        sums[j] += fabs(A->matrix[i][j]);
+      }
+    }
+    for (int j = 0; j < A->columns; j++) {
+      norm = max_or_nan(sums[j], norm);
+    }
+    s21_workspace_release(ctx, sums);
+  } else {
+    err = CALCERR;
+  }
+
+  if (err == OK) {
+    *result = norm;
+  }
+
+  return err;
+}
@@ -1,3 +1,6 @@
+#include <time.h>
+
+#include "s21_fixed.h"
 #include "s21_matrix.h"
 #include "tests.h"
 
@@ -475,6 +478,12 @@ START_TEST(s21_inverse_matrix_test) {
   result = s21_inverse_matrix(&m1, &m2);
   ck_assert_int_eq(result, WRONGMAT);
 
+  // Test 2a (sizes without storage)
+  m1.matrix = NULL;
+  m1.rows = m1.columns = 3;
+  result = s21_inverse_matrix(&m1, &m2);
+  ck_assert_int_eq(result, WRONGMAT);
+
   // Test for non-square matrix
 
   // Test 3
@@ -539,6 +548,1248 @@ START_TEST(s21_inverse_matrix_test) {
 }
 END_TEST
 
+static int allocations = 0;
+
+static void *counting_alloc(size_t size, void *user) {
+  (*(int *)user)++;
+  return malloc(size);
+}
+
+static void counting_release(void *ptr, size_t size, void *user) {
+  (void)size;
+  (*(int *)user)--;
+  free(ptr);
+}
+
+START_TEST(s21_context_test) {
+  s21_context_t *ctx;
+  s21_allocator_t counting = {counting_alloc, counting_release, &allocations};
+  matrix_t m1, m2, m3;
+  double det;
+  int result;
+
+  result = s21_context_create(&ctx);
+  ck_assert_int_eq(result, OK);
+  result = s21_context_set_allocator(ctx, counting);
+  ck_assert_int_eq(result, OK);
+  ck_assert_int_eq(s21_context_set_threads(ctx, -1), WRONGMAT);
+  ck_assert_int_eq(s21_context_set_accumulation(ctx, ACCUM_DOT2 + 1), WRONGMAT);
+  ck_assert_int_eq(s21_context_set_check_finite(NULL, 1), WRONGMAT);
+
+  s21_create_matrix_ctx(ctx, 3, 3, &m1);
+  m1.matrix[0][0] = 2;
+  m1.matrix[0][1] = 5;
+  m1.matrix[0][2] = 7;
+  m1.matrix[1][0] = 6;
+  m1.matrix[1][1] = 3;
+  m1.matrix[1][2] = 4;
+  m1.matrix[2][0] = 5;
+  m1.matrix[2][1] = -2;
+  m1.matrix[2][2] = -3;
+  ck_assert_int_eq(allocations, 1);
+
+  result = s21_determinant_ctx(ctx, &m1, &det);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq_tol(det, -1, 1e-7);
+  ck_assert_int_eq(allocations, 2);
+
+  // workspace stays allocated across calls and only grows when needed
+  result = s21_determinant_ctx(ctx, &m1, &det);
+  ck_assert_int_eq(allocations, 2);
+  result = s21_inverse_matrix_ctx(ctx, &m1, &m2);
+  ck_assert_int_eq(result, OK);
+  result = s21_mult_matrix_ctx(ctx, &m1, &m2, &m3);
+  ck_assert_int_eq(result, OK);
+  result = s21_determinant_ctx(ctx, &m3, &det);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq_tol(det, 1, 1e-7);
+  ck_assert_int_eq(allocations, 4);
+
+  s21_remove_matrix_ctx(ctx, &m1);
+  s21_remove_matrix_ctx(ctx, &m2);
+  s21_remove_matrix_ctx(ctx, &m3);
+  ck_assert_int_eq(allocations, 1);
+
+  s21_context_destroy(ctx);
+  ck_assert_int_eq(allocations, 0);
+
+  // singular matrices have no inverse even when rounding leaves a pivot
+  s21_create_matrix(3, 3, &m1);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      m1.matrix[i][j] = i * 3 + j + 1;
+    }
+  }
+  result = s21_inverse_matrix_ctx(NULL, &m1, &m2);
+  ck_assert_int_eq(result, CALCERR);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_solve_matrix_test) {
+  matrix_t m1, m2, m3;
+  int result;
+
+  s21_create_matrix(3, 3, &m1);
+  s21_create_matrix(3, 1, &m2);
+  m1.matrix[0][0] = 2;
+  m1.matrix[0][1] = 5;
+  m1.matrix[0][2] = 7;
+  m1.matrix[1][0] = 6;
+  m1.matrix[1][1] = 3;
+  m1.matrix[1][2] = 4;
+  m1.matrix[2][0] = 5;
+  m1.matrix[2][1] = -2;
+  m1.matrix[2][2] = -3;
+  m2.matrix[0][0] = 14;
+  m2.matrix[1][0] = 13;
+  m2.matrix[2][0] = 0;
+
+  double res1[3] = {1, 1, 1};
+
+  result = s21_solve_matrix(&m1, &m2, &m3);
+  ck_assert_int_eq(result, OK);
+  for (int i = 0; i < 3; i++) {
+    ck_assert_double_eq_tol(m3.matrix[i][0], res1[i], 1e-7);
+  }
+  s21_remove_matrix(&m3);
+
+  m1.matrix[2][0] = 8;
+  m1.matrix[2][1] = 8;
+  m1.matrix[2][2] = 11;
+  result = s21_solve_matrix(&m1, &m2, &m3);
+  ck_assert_int_eq(result, CALCERR);
+  s21_remove_matrix(&m2);
+
+  s21_create_matrix(2, 1, &m2);
+  result = s21_solve_matrix(&m1, &m2, &m3);
+  ck_assert_int_eq(result, CALCERR);
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+}
+END_TEST
+
+START_TEST(s21_blocked_lu_test) {
+  s21_context_t *serial;
+  matrix_t m1, m2, m3;
+  double det, serial_det;
+  int n = 300, result;
+
+  s21_context_create(&serial);
+  s21_context_set_threads(serial, 1);
+
+  s21_create_matrix(n, n, &m1);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      m1.matrix[i][j] = (i == j) + 0.01 * sin(i * 7.0 + j * 3.0);
+    }
+  }
+
+  result = s21_determinant(&m1, &det);
+  ck_assert_int_eq(result, OK);
+  result = s21_determinant_ctx(serial, &m1, &serial_det);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq_tol(det / serial_det, 1, 1e-9);
+
+  // queued futures never run inside the caller's own factorization
+  s21_future_t *futures[4];
+  double dets[4];
+  for (int i = 0; i < 4; i++) {
+    futures[i] = s21_async_determinant(NULL, &m1, &dets[i], NULL, 0);
+  }
+  result = s21_determinant(&m1, &det);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq_tol(det / serial_det, 1, 1e-9);
+  for (int i = 0; i < 4; i++) {
+    ck_assert_int_eq(s21_future_wait(futures[i]), OK);
+    ck_assert_double_eq_tol(dets[i] / serial_det, 1, 1e-9);
+    s21_future_release(futures[i]);
+  }
+
+  result = s21_inverse_matrix(&m1, &m2);
+  ck_assert_int_eq(result, OK);
+  result = s21_mult_matrix(&m1, &m2, &m3);
+  ck_assert_int_eq(result, OK);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      ck_assert_double_eq_tol(m3.matrix[i][j], i == j, 1e-9);
+    }
+  }
+
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+  s21_remove_matrix(&m3);
+  s21_context_destroy(serial);
+}
+END_TEST
+
+START_TEST(s21_fixed_matrix_test) {
+  s21_mat3_t a = {{{2, 5, 7}, {6, 3, 4}, {5, -2, -3}}}, b, c;
+  s21_mat2_t d = {{{1, 2}, {3, 4}}}, e;
+  s21_mat8_t f;
+  matrix_t m1;
+  double det;
+  int result;
+
+  double res1[3][3] = {{1, -1, 1}, {-38, 41, -34}, {27, -29, 24}};
+
+  ck_assert_double_eq_tol(s21_mat3_determinant(&a), -1, 1e-7);
+  result = s21_mat3_inverse(&a, &b);
+  ck_assert_int_eq(result, OK);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      ck_assert_double_eq_tol(b.m[i][j], res1[i][j], 1e-7);
+    }
+  }
+
+  s21_mat3_mult(&a, &b, &c);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      ck_assert_double_eq_tol(c.m[i][j], i == j, 1e-7);
+    }
+  }
+
+  s21_mat2_transpose(&d, &e);
+  ck_assert_double_eq(e.m[0][1], 3);
+  ck_assert_double_eq(e.m[1][0], 2);
+  d.m[1][0] = 2;
+  d.m[1][1] = 4;
+  ck_assert_int_eq(s21_mat2_inverse(&d, &e), CALCERR);
+
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 8; j++) {
+      f.m[i][j] = (i == j) * 2 + 0.1 * (i + 1) * (j % 3);
+    }
+  }
+  result = s21_mat8_to_matrix(&f, &m1);
+  ck_assert_int_eq(result, OK);
+  s21_determinant(&m1, &det);
+  ck_assert_double_eq_tol(s21_mat8_determinant(&f), det, 1e-9);
+  ck_assert_int_eq(s21_mat3_from_matrix(&m1, &a), CALCERR);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_matrix_pow_test) {
+  matrix_t m1, m2, m3;
+  int result;
+
+  s21_create_matrix(2, 2, &m1);
+  m1.matrix[0][0] = 1;
+  m1.matrix[0][1] = 1;
+  m1.matrix[1][0] = 1;
+  m1.matrix[1][1] = 0;
+
+  double res1[2][2] = {{89, 55}, {55, 34}};
+
+  result = s21_matrix_pow(&m1, 10, &m2);
+  ck_assert_int_eq(result, OK);
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      ck_assert_double_eq(m2.matrix[i][j], res1[i][j]);
+    }
+  }
+
+  // A^-10 * A^10 = I and A^0 = I
+  result = s21_matrix_pow(&m1, -10, &m3);
+  ck_assert_int_eq(result, OK);
+  s21_remove_matrix(&m1);
+  s21_mult_matrix(&m2, &m3, &m1);
+  s21_remove_matrix(&m2);
+  s21_remove_matrix(&m3);
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      ck_assert_double_eq_tol(m1.matrix[i][j], i == j, 1e-7);
+    }
+  }
+  result = s21_matrix_pow(&m1, 0, &m2);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq(m2.matrix[0][0], 1);
+  ck_assert_double_eq(m2.matrix[0][1], 0);
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+
+  s21_create_matrix(2, 3, &m1);
+  result = s21_matrix_pow(&m1, 2, &m2);
+  ck_assert_int_eq(result, CALCERR);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_matrix_exp_test) {
+  matrix_t m1, m2;
+  double angles[] = {0.001, 0.5, 2, 10};
+  int result;
+
+  // exp of t * [[0, 1], [-1, 0]] is a rotation by t, the angles cover every
+  // pade degree and scaling
+  s21_create_matrix(2, 2, &m1);
+  for (int k = 0; k < 4; k++) {
+    double t = angles[k];
+    m1.matrix[0][0] = 0;
+    m1.matrix[0][1] = t;
+    m1.matrix[1][0] = -t;
+    m1.matrix[1][1] = 0;
+
+    result = s21_matrix_exp(&m1, &m2);
+    ck_assert_int_eq(result, OK);
+    ck_assert_double_eq_tol(m2.matrix[0][0], cos(t), 1e-12);
+    ck_assert_double_eq_tol(m2.matrix[0][1], sin(t), 1e-12);
+    ck_assert_double_eq_tol(m2.matrix[1][0], -sin(t), 1e-12);
+    ck_assert_double_eq_tol(m2.matrix[1][1], cos(t), 1e-12);
+    s21_remove_matrix(&m2);
+  }
+
+  m1.matrix[0][0] = 1;
+  m1.matrix[0][1] = 0;
+  m1.matrix[1][0] = 0;
+  m1.matrix[1][1] = -2;
+  result = s21_matrix_exp(&m1, &m2);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_eq_tol(m2.matrix[0][0], exp(1), 1e-12);
+  ck_assert_double_eq_tol(m2.matrix[1][1], exp(-2), 1e-12);
+  ck_assert_double_eq_tol(m2.matrix[0][1], 0, 1e-12);
+  s21_remove_matrix(&m2);
+
+  // a nan column next to a finite one must not pass the norm check
+  m1.matrix[0][0] = NAN;
+  result = s21_matrix_exp(&m1, &m2);
+  ck_assert_int_eq(result, NONFINITE);
+  m1.matrix[0][0] = 1;
+  m1.matrix[1][1] = INFINITY;
+  result = s21_matrix_exp(&m1, &m2);
+  ck_assert_int_eq(result, NONFINITE);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_vector_test) {
+  matrix_t m1;
+  vector_t x, y, row;
+  double result;
+  int err;
+
+  s21_create_matrix(2, 9, &m1);
+  s21_create_vector(9, &x);
+  s21_create_vector(2, &y);
+  for (int j = 0; j < 9; j++) {
+    m1.matrix[0][j] = j + 1;
+    m1.matrix[1][j] = j % 2 ? -1 : 1;
+    x.data[j] = 1;
+  }
+
+  err = s21_gemv(1, &m1, &x, 0, &y);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(y.data[0], 45);
+  ck_assert_double_eq(y.data[1], 1);
+
+  err = s21_gemv(2, &m1, &x, -1, &y);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(y.data[0], 45);
+  ck_assert_double_eq(y.data[1], 1);
+
+  err = s21_gemv_t(1, &m1, &y, 0, &x);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(x.data[0], 46);
+  ck_assert_double_eq(x.data[8], 406);
+
+  s21_matrix_row(&m1, 0, &row);
+  err = s21_dot(&row, &row, &result);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(result, 285);
+  err = s21_nrm2(&row, &result);
+  ck_assert_double_eq_tol(result, sqrt(285), 1e-12);
+
+  err = s21_axpy(-1, &row, &x);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(x.data[0], 45);
+  ck_assert_double_eq(x.data[8], 397);
+
+  err = s21_dot(&row, &y, &result);
+  ck_assert_int_eq(err, CALCERR);
+  err = s21_gemv(1, &m1, &y, 0, &x);
+  ck_assert_int_eq(err, CALCERR);
+
+  // nrm2 neither overflows nor underflows
+  x.data[0] = 3e200;
+  x.data[1] = 4e200;
+  for (int j = 2; j < 9; j++) {
+    x.data[j] = 0;
+  }
+  s21_nrm2(&x, &result);
+  ck_assert_double_eq_tol(result / 5e200, 1, 1e-15);
+  x.data[0] = 3e-200;
+  x.data[1] = 4e-200;
+  s21_nrm2(&x, &result);
+  ck_assert_double_eq_tol(result / 5e-200, 1, 1e-15);
+
+  err = s21_norm_matrix(&m1, NORM_ONE, &result);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(result, 10);
+  s21_norm_matrix(&m1, NORM_INF, &result);
+  ck_assert_double_eq(result, 45);
+  s21_norm_matrix(&m1, NORM_FRO, &result);
+  ck_assert_double_eq_tol(result, sqrt(294), 1e-12);
+  err = s21_norm_matrix(&m1, 7, &result);
+  ck_assert_int_eq(err, CALCERR);
+
+  s21_remove_vector(&x);
+  s21_remove_vector(&y);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_handle_test) {
+  s21_handle_t *A, *B, *C;
+  matrix_t m1;
+  double *data, value;
+  int stride, err;
+
+  ck_assert_int_eq(s21_abi_version(), S21_ABI_VERSION);
+  err = s21_handle_create(2, 3, &A);
+  ck_assert_int_eq(err, OK);
+  ck_assert_int_eq(s21_handle_rows(A), 2);
+  ck_assert_int_eq(s21_handle_columns(A), 3);
+  data = s21_handle_data(A, &stride);
+  ck_assert_int_ge(stride, 3);
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 3; j++) {
+      ck_assert_double_eq(data[i * stride + j], 0);
+      data[i * stride + j] = i * 3 + j;
+    }
+  }
+  s21_handle_get(A, 1, 2, &value);
+  ck_assert_double_eq(value, 5);
+  err = s21_handle_set(A, 0, 0, 7);
+  ck_assert_int_eq(err, OK);
+  err = s21_handle_get(A, 2, 0, &value);
+  ck_assert_int_eq(err, CALCERR);
+
+  err = s21_handle_transpose(A, &B);
+  ck_assert_int_eq(err, OK);
+  err = s21_handle_mult(A, B, &C);
+  ck_assert_int_eq(err, OK);
+  s21_handle_get(C, 0, 1, &value);
+  ck_assert_double_eq(value, 7 * 3 + 1 * 4 + 2 * 5);
+  s21_handle_determinant(C, &value);
+  ck_assert_double_eq_tol(value, 54 * 50 - 35 * 35, 1e-9);
+  err = s21_handle_sum(A, C, &B);
+  ck_assert_int_eq(err, CALCERR);
+  s21_handle_release(B);
+
+  err = s21_handle_to_matrix(C, &m1);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(m1.matrix[1][1], 50);
+  s21_handle_release(C);
+  err = s21_handle_from_matrix(&m1, &C);
+  ck_assert_int_eq(err, OK);
+  err = s21_handle_inverse(C, &B);
+  ck_assert_int_eq(err, OK);
+  s21_handle_get(B, 0, 0, &value);
+  ck_assert_double_eq_tol(value, 50.0 / (54 * 50 - 35 * 35), 1e-12);
+  ck_assert_int_eq(s21_handle_eq(C, C), SUCCESS);
+  ck_assert_int_eq(s21_handle_eq(A, C), FAILURE);
+
+  ck_assert_int_eq(s21_handle_create(0, 3, &C), WRONGMAT);
+  ck_assert_ptr_null(s21_handle_data(NULL, &stride));
+
+  s21_remove_matrix(&m1);
+  s21_handle_release(A);
+  s21_handle_release(B);
+  s21_handle_release(C);
+}
+END_TEST
+
+START_TEST(s21_accumulation_test) {
+  s21_context_t *ctx;
+  matrix_t m1, m2, m3, product, result;
+  vector_t x, y;
+  double value;
+  int err, k = 1000;
+
+  s21_context_create(&ctx);
+
+  // 1 + 1e100 + 1 - 1e100 along every row, the naive sum loses both ones;
+  // powers of two in m2 keep the products exact
+  s21_create_matrix(3, k, &m1);
+  s21_create_matrix(k, 6, &m2);
+  for (int p = 0; p < k; p++) {
+    for (int i = 0; i < 3; i++) {
+      m1.matrix[i][p] = p % 4 == 1 ? 1e100 : p % 4 == 3 ? -1e100 : 1;
+    }
+    for (int j = 0; j < 6; j++) {
+      m2.matrix[p][j] = ldexp(1, j);
+    }
+  }
+
+  // a new context sums naively
+  int modes[] = {-1, ACCUM_NAIVE, ACCUM_PAIRWISE, ACCUM_KAHAN, ACCUM_DOT2};
+  for (int mode = 0; mode < 5; mode++) {
+    if (modes[mode] >= 0) {
+      s21_context_set_accumulation(ctx, modes[mode]);
+    }
+    err = s21_mult_matrix_ctx(ctx, &m1, &m2, &result);
+    ck_assert_int_eq(err, OK);
+    for (int j = 0; j < 6; j++) {
+      if (modes[mode] >= ACCUM_KAHAN) {
+        ck_assert_double_eq(result.matrix[2][j], ldexp(k / 2, j));
+      } else {
+        ck_assert_double_lt(result.matrix[2][j], ldexp(k / 2, j));
+      }
+    }
+    s21_remove_matrix_ctx(ctx, &result);
+  }
+
+  // powers multiply like mult_matrix: 1 + 1e100 + 1 - 1e100 again
+  s21_create_matrix(4, 4, &m3);
+  m3.matrix[0][1] = 1e100;
+  m3.matrix[0][3] = -1e100;
+  for (int i = 0; i < 4; i++) {
+    m3.matrix[i][0] = 1;
+  }
+  m3.matrix[0][2] = 1;
+  for (int mode = ACCUM_NAIVE; mode <= ACCUM_DOT2; mode++) {
+    s21_context_set_accumulation(ctx, mode);
+    err = s21_matrix_pow_ctx(ctx, &m3, 2, &result);
+    ck_assert_int_eq(err, OK);
+    s21_mult_matrix_ctx(ctx, &m3, &m3, &product);
+    ck_assert_double_eq(result.matrix[0][0], product.matrix[0][0]);
+    if (mode >= ACCUM_KAHAN) {
+      ck_assert_double_eq(result.matrix[0][0], 2);
+    }
+    s21_remove_matrix_ctx(ctx, &result);
+    s21_remove_matrix_ctx(ctx, &product);
+  }
+  s21_remove_matrix(&m3);
+
+  // pairwise and naive agree on benign data
+  for (int p = 0; p < k; p++) {
+    m1.matrix[0][p] = 1.0 / (p + 1);
+  }
+  s21_context_set_accumulation(ctx, ACCUM_PAIRWISE);
+  s21_mult_matrix_ctx(ctx, &m1, &m2, &result);
+  ck_assert_double_eq_tol(result.matrix[0][4], 16 * 7.485470860550345, 1e-12);
+  s21_remove_matrix_ctx(ctx, &result);
+
+  // (1 + 2^-30)(1 - 2^-30) - 1 needs the exact product
+  s21_create_vector(2, &x);
+  s21_create_vector(2, &y);
+  x.data[0] = 1 + ldexp(1, -30);
+  x.data[1] = -1;
+  y.data[0] = 1 - ldexp(1, -30);
+  y.data[1] = 1;
+  s21_context_set_accumulation(ctx, ACCUM_KAHAN);
+  s21_dot_ctx(ctx, &x, &y, &value);
+  ck_assert_double_eq(value, 0);
+  s21_context_set_accumulation(ctx, ACCUM_DOT2);
+  err = s21_dot_ctx(ctx, &x, &y, &value);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(value, -ldexp(1, -60));
+
+  s21_remove_vector(&x);
+  s21_remove_vector(&y);
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+  s21_context_destroy(ctx);
+}
+END_TEST
+
+START_TEST(s21_nonfinite_test) {
+  s21_context_t *ctx;
+  matrix_t m1, m2, result;
+  double det;
+  volatile double tiny = 1e-310;
+  int err;
+
+  s21_context_create(&ctx);
+  s21_create_matrix(3, 3, &m1);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      m1.matrix[i][j] = i == j;
+    }
+  }
+  ck_assert_int_eq(s21_check_finite(&m1), OK);
+
+  // a zero pivot column used to hide the nan from the determinant
+  m1.matrix[0][0] = 0;
+  m1.matrix[1][0] = 0;
+  m1.matrix[2][2] = NAN;
+  ck_assert_int_eq(s21_check_finite(&m1), NONFINITE);
+  err = s21_determinant(&m1, &det);
+  ck_assert_int_eq(err, NONFINITE);
+  ck_assert_double_nan(det);
+  m1.matrix[2][2] = INFINITY;
+  err = s21_inverse_matrix(&m1, &result);
+  ck_assert_int_eq(err, NONFINITE);
+  err = s21_calc_complements(&m1, &result);
+  ck_assert_int_eq(err, NONFINITE);
+
+  // the iterations and factorizations refuse nan and inf up front instead of
+  // running out of sweeps or returning them as a result, a missing matrix
+  // stays WRONGMAT
+  for (int k = 0; k < 2; k++) {
+    matrix_t values, vectors, U, S, V;
+    int iterations;
+
+    m1.matrix[2][2] = k ? NAN : INFINITY;
+    err = s21_eigen_symmetric(&m1, &values, &vectors, &iterations);
+    ck_assert_int_eq(err, NONFINITE);
+    err = s21_svd_matrix(&m1, &U, &S, &V, &iterations);
+    ck_assert_int_eq(err, NONFINITE);
+    err = s21_qr_matrix(&m1, &U, &S);
+    ck_assert_int_eq(err, NONFINITE);
+    err = s21_matrix_pow(&m1, 3, &result);
+    ck_assert_int_eq(err, NONFINITE);
+  }
+  m2.matrix = NULL;
+  m2.rows = m2.columns = 3;
+  ck_assert_int_eq(s21_check_finite(&m2), WRONGMAT);
+  err = s21_matrix_pow(&m2, 3, &result);
+  ck_assert_int_eq(err, WRONGMAT);
+  m1.matrix[2][2] = INFINITY;
+
+  // ieee propagation unless the context asks for checks
+  err = s21_mult_number(&m1, 2, &result);
+  ck_assert_int_eq(err, OK);
+  s21_remove_matrix(&result);
+  s21_context_set_check_finite(ctx, 1);
+  err = s21_mult_number_ctx(ctx, &m1, 2, &result);
+  ck_assert_int_eq(err, NONFINITE);
+
+  // overflow of finite inputs
+  s21_create_matrix(1, 1, &m2);
+  m2.matrix[0][0] = 1e200;
+  err = s21_mult_matrix_ctx(ctx, &m2, &m2, &result);
+  ck_assert_int_eq(err, NONFINITE);
+  s21_context_set_check_finite(ctx, 0);
+  err = s21_mult_matrix_ctx(ctx, &m2, &m2, &result);
+  ck_assert_int_eq(err, OK);
+  s21_remove_matrix_ctx(ctx, &result);
+
+  // ones everywhere plus 1e-15 on two diagonal entries, the pivots pass
+  // the singularity check but the condition number is about 1e16
+  s21_remove_matrix(&m1);
+  s21_create_matrix(3, 3, &m1);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      m1.matrix[i][j] = i == j && i > 0 ? 1 + 1e-15 : 1;
+    }
+  }
+  err = s21_inverse_matrix(&m1, &result);
+  ck_assert_int_eq(err, ILLCOND);
+  m1.matrix[1][1] = m1.matrix[2][2] = 2;
+  err = s21_inverse_matrix(&m1, &result);
+  ck_assert_int_eq(err, OK);
+  s21_remove_matrix(&result);
+
+  // a subnormal pivot is kept on every backend unless flushing is asked for
+  s21_create_matrix(2, 2, &result);
+  result.matrix[0][0] = tiny;
+  result.matrix[0][1] = result.matrix[1][0] = 0;
+  result.matrix[1][1] = 1;
+  err = s21_determinant_ctx(ctx, &result, &det);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(det, 1e-310);
+
+#if defined(__SSE2__)
+  s21_context_set_flush_denormals(ctx, 1);
+  err = s21_determinant_ctx(ctx, &result, &det);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(det, 0);
+  s21_remove_matrix(&result);
+
+  // flush applies inside the call only
+  m2.matrix[0][0] = tiny;
+  err = s21_mult_number_ctx(ctx, &m2, 1, &result);
+  ck_assert_int_eq(err, OK);
+  ck_assert_double_eq(result.matrix[0][0], 0);
+  s21_remove_matrix_ctx(ctx, &result);
+  ck_assert_double_eq(tiny * 1.0, 1e-310);
+#else
+  s21_remove_matrix(&result);
+#endif
+  (void)tiny;
+
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+  s21_context_destroy(ctx);
+}
+END_TEST
+
+START_TEST(s21_copy_matrix_test) {
+  matrix_t m1, result;
+  s21_handle_t *A, *B;
+  const double *shared;
+  double value;
+  int err;
+
+  s21_create_matrix(3, 4, &m1);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      m1.matrix[i][j] = i * 4 + j;
+    }
+  }
+  m1.matrix[2][3] = NAN;
+  err = s21_copy_matrix(&m1, &result);
+  ck_assert_int_eq(err, OK);
+  ck_assert_int_eq(result.rows, 3);
+  ck_assert_int_eq(result.columns, 4);
+  ck_assert_ptr_ne(result.matrix[0], m1.matrix[0]);
+  ck_assert_double_eq(result.matrix[1][2], 6);
+  ck_assert_double_nan(result.matrix[2][3]);
+  s21_remove_matrix(&result);
+  m1.rows = 0;
+  ck_assert_int_eq(s21_copy_matrix(&m1, &result), WRONGMAT);
+  m1.rows = 3;
+
+  // clones share storage until the first write
+  s21_handle_from_matrix(&m1, &A);
+  err = s21_handle_clone(A, &B);
+  ck_assert_int_eq(err, OK);
+  ck_assert_int_eq(s21_handle_shared(A), 2);
+  shared = s21_handle_read_data(A, NULL);
+  ck_assert_ptr_eq(s21_handle_read_data(B, NULL), shared);
+
+  err = s21_handle_set(B, 0, 0, -1);
+  ck_assert_int_eq(err, OK);
+  ck_assert_ptr_eq(s21_handle_read_data(A, NULL), shared);
+  ck_assert_ptr_ne(s21_handle_read_data(B, NULL), shared);
+  ck_assert_int_eq(s21_handle_shared(A), 1);
+  ck_assert_int_eq(s21_handle_shared(B), 1);
+  s21_handle_get(A, 0, 0, &value);
+  ck_assert_double_eq(value, 0);
+  s21_handle_get(B, 0, 0, &value);
+  ck_assert_double_eq(value, -1);
+  s21_handle_get(B, 1, 1, &value);
+  ck_assert_double_eq(value, 5);
+
+  // a sole owner writes in place, a released clone unshares the other
+  s21_handle_set(A, 0, 1, 9);
+  ck_assert_ptr_eq(s21_handle_read_data(A, NULL), shared);
+  s21_handle_release(B);
+  s21_handle_clone(A, &B);
+  s21_handle_release(A);
+  ck_assert_int_eq(s21_handle_shared(B), 1);
+  ck_assert_ptr_eq(s21_handle_data(B, NULL), shared);
+  ck_assert_double_eq(shared[1], 9);
+
+  s21_handle_release(B);
+  s21_remove_matrix(&m1);
+}
+END_TEST
+
+START_TEST(s21_hugepage_test) {
+  s21_context_t *ctx;
+  matrix_t m1, m2, result, expected;
+  int err, zero = 1;
+
+  s21_context_create(&ctx);
+  s21_context_set_allocator(ctx, s21_hugepage_allocator());
+  s21_context_set_first_touch(ctx, 1);
+
+  // 600 x 600 doubles span more than one huge page and start on a boundary
+  err = s21_create_matrix_ctx(ctx, 600, 600, &m1);
+  ck_assert_int_eq(err, OK);
+  ck_assert_int_eq((long)((size_t)m1.matrix % ((size_t)2 << 20)), 0);
+  for (int i = 0; i < 600; i++) {
+    for (int j = 0; j < 600; j++) {
+      zero &= m1.matrix[i][j] == 0;
+      m1.matrix[i][j] = (i + 2 * j) % 7 - 3;
+    }
+  }
+  ck_assert_int_eq(zero, 1);
+
+  // small blocks and the workspace go through the same allocator
+  err = s21_create_matrix_ctx(ctx, 600, 3, &m2);
+  ck_assert_int_eq(err, OK);
+  for (int i = 0; i < 600; i++) {
+    for (int j = 0; j < 3; j++) {
+      m2.matrix[i][j] = i == j;
+    }
+  }
+  err = s21_context_reserve(ctx, (size_t)5 << 20);
+  ck_assert_int_eq(err, OK);
+  err = s21_mult_matrix_ctx(ctx, &m1, &m2, &result);
+  ck_assert_int_eq(err, OK);
+  s21_mult_matrix(&m1, &m2, &expected);
+  ck_assert_int_eq(s21_eq_matrix(&result, &expected), SUCCESS);
+
+  s21_remove_matrix(&expected);
+  s21_remove_matrix_ctx(ctx, &result);
+  s21_remove_matrix_ctx(ctx, &m2);
+  s21_remove_matrix_ctx(ctx, &m1);
+  s21_context_destroy(ctx);
+}
+END_TEST
+
+static void check_cache(s21_inverse_cache_t *cache) {
+  matrix_t inverse;
+  double det;
+
+  s21_inverse_matrix(&cache->A, &inverse);
+  s21_determinant(&cache->A, &det);
+  ck_assert_double_eq_tol(cache->determinant, det, 1e-9 * fabs(det));
+  for (int i = 0; i < inverse.rows; i++) {
+    for (int j = 0; j < inverse.columns; j++) {
+      ck_assert_double_eq_tol(cache->inverse.matrix[i][j],
+                              inverse.matrix[i][j], 1e-9);
+    }
+  }
+  s21_remove_matrix(&inverse);
+}
+
+START_TEST(s21_inverse_cache_test) {
+  s21_inverse_cache_t cache;
+  matrix_t m1, u, v, U, V, before;
+  int n = 6, result;
+
+  s21_create_matrix(n, n, &m1);
+  s21_create_matrix(n, 1, &u);
+  s21_create_matrix(1, n, &v);
+  s21_create_matrix(n, 2, &U);
+  s21_create_matrix(n, 2, &V);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      m1.matrix[i][j] = (i == j) * 4 + sin(i + 2.0 * j);
+    }
+    u.matrix[i][0] = cos(i);
+    v.matrix[0][i] = sin(3.0 * i);
+    U.matrix[i][0] = 0.1 * i;
+    U.matrix[i][1] = 1.0 / (i + 1);
+    V.matrix[i][0] = cos(2.0 * i);
+    V.matrix[i][1] = 0.5;
+  }
+
+  before.matrix = NULL;
+  before.rows = before.columns = n;
+  result = s21_inverse_cache_init(NULL, &before, &cache);
+  ck_assert_int_eq(result, WRONGMAT);
+
+  result = s21_inverse_cache_init(NULL, &m1, &cache);
+  ck_assert_int_eq(result, OK);
+  cache.check_interval = 2;
+
+  result = s21_rank1_update(&cache, &u, &v);
+  ck_assert_int_eq(result, OK);
+  check_cache(&cache);
+
+  result = s21_row_update(&cache, 2, &v);
+  ck_assert_int_eq(result, OK);
+  check_cache(&cache);
+
+  result = s21_column_update(&cache, 4, &u);
+  ck_assert_int_eq(result, OK);
+  check_cache(&cache);
+
+  result = s21_rank_update(&cache, &U, &V);
+  ck_assert_int_eq(result, OK);
+  check_cache(&cache);
+  ck_assert_int_eq(cache.refactorizations, 0);
+
+  // a row equal to another row makes the update singular, the cache keeps
+  // the matrix its inverse and determinant belong to
+  for (int i = 0; i < n; i++) {
+    v.matrix[0][i] = cache.A.matrix[0][i];
+  }
+  s21_copy_matrix(&cache.A, &before);
+  result = s21_row_update(&cache, 1, &v);
+  ck_assert_int_eq(result, CALCERR);
+  ck_assert_int_eq(s21_eq_matrix(&cache.A, &before), SUCCESS);
+  check_cache(&cache);
+  for (int i = 0; i < n; i++) {
+    U.matrix[i][0] = i == 1;
+    U.matrix[i][1] = 0;
+    V.matrix[i][0] = cache.A.matrix[0][i] - cache.A.matrix[1][i];
+  }
+  result = s21_rank_update(&cache, &U, &V);
+  ck_assert_int_eq(result, CALCERR);
+  ck_assert_int_eq(s21_eq_matrix(&cache.A, &before), SUCCESS);
+  check_cache(&cache);
+  s21_remove_matrix(&before);
+
+  result = s21_row_update(&cache, n, &v);
+  ck_assert_int_eq(result, WRONGMAT);
+  result = s21_rank1_update(&cache, &U, &v);
+  ck_assert_int_eq(result, WRONGMAT);
+
+  s21_inverse_cache_remove(&cache);
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&u);
+  s21_remove_matrix(&v);
+  s21_remove_matrix(&U);
+  s21_remove_matrix(&V);
+}
+END_TEST
+
+static double max_reconstruction_error(matrix_t *A, matrix_t *B,
+                                       matrix_t *C) {
+  matrix_t product;
+  double err = 0.0;
+
+  s21_mult_matrix(B, C, &product);
+  for (int i = 0; i < A->rows; i++) {
+    for (int j = 0; j < A->columns; j++) {
+      err = fmax(err, fabs(product.matrix[i][j] - A->matrix[i][j]));
+    }
+  }
+  s21_remove_matrix(&product);
+
+  return err;
+}
+
+// max |Q^T Q - I| over the columns of Q
+static double max_orthogonality_error(matrix_t *Q) {
+  matrix_t qt, product;
+  double err = 0.0;
+
+  s21_transpose(Q, &qt);
+  s21_mult_matrix(&qt, Q, &product);
+  for (int i = 0; i < Q->columns; i++) {
+    for (int j = 0; j < Q->columns; j++) {
+      err = fmax(err, fabs(product.matrix[i][j] - (i == j)));
+    }
+  }
+  s21_remove_matrix(&qt);
+  s21_remove_matrix(&product);
+
+  return err;
+}
+
+START_TEST(s21_decomposition_test) {
+  matrix_t m1, m2, values, vectors, U, S, V, Q, R, scaled, vt;
+  int iterations, result;
+
+  s21_create_matrix(3, 3, &m1);
+  m1.matrix[0][0] = 2;
+  m1.matrix[0][1] = -1;
+  m1.matrix[0][2] = 0;
+  m1.matrix[1][0] = -1;
+  m1.matrix[1][1] = 2;
+  m1.matrix[1][2] = -1;
+  m1.matrix[2][0] = 0;
+  m1.matrix[2][1] = -1;
+  m1.matrix[2][2] = 2;
+
+  double res1[3] = {2 - sqrt(2), 2, 2 + sqrt(2)};
+
+  result = s21_eigen_symmetric(&m1, &values, &vectors, &iterations);
+  ck_assert_int_eq(result, OK);
+  ck_assert_int_gt(iterations, 0);
+  for (int i = 0; i < 3; i++) {
+    ck_assert_double_eq_tol(values.matrix[i][0], res1[i], 1e-12);
+  }
+  // A * v = lambda * v for every column
+  s21_mult_matrix(&m1, &vectors, &m2);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      ck_assert_double_eq_tol(m2.matrix[i][j],
+                              values.matrix[j][0] * vectors.matrix[i][j],
+                              1e-12);
+    }
+  }
+  s21_remove_matrix(&m2);
+  s21_remove_matrix(&values);
+  s21_remove_matrix(&vectors);
+  s21_remove_matrix(&m1);
+
+  // wide and tall inputs reconstruct from U * S * V^T
+  for (int t = 0; t < 2; t++) {
+    s21_create_matrix(t ? 5 : 3, t ? 3 : 5, &m1);
+    for (int i = 0; i < m1.rows; i++) {
+      for (int j = 0; j < m1.columns; j++) {
+        m1.matrix[i][j] = sin(i * 3.0 + j * 5.0 + 1.0);
+      }
+    }
+
+    result = s21_svd_matrix(&m1, &U, &S, &V, &iterations);
+    ck_assert_int_eq(result, OK);
+    ck_assert_int_eq(U.rows, m1.rows);
+    ck_assert_int_eq(V.rows, m1.columns);
+    ck_assert_double_le(S.matrix[1][0], S.matrix[0][0]);
+    ck_assert_double_le(S.matrix[2][0], S.matrix[1][0]);
+
+    s21_create_matrix(3, V.rows, &scaled);
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < V.rows; j++) {
+        scaled.matrix[i][j] = S.matrix[i][0] * V.matrix[j][i];
+      }
+    }
+    ck_assert_double_lt(max_reconstruction_error(&m1, &U, &scaled), 1e-12);
+    s21_remove_matrix(&scaled);
+
+    result = s21_qr_matrix(&m1, &Q, &R);
+    if (t) {
+      ck_assert_int_eq(result, OK);
+      ck_assert_double_eq_tol(R.matrix[2][0], 0, 1e-15);
+      ck_assert_double_lt(max_reconstruction_error(&m1, &Q, &R), 1e-12);
+      s21_transpose(&Q, &vt);
+      s21_mult_matrix(&vt, &Q, &m2);
+      for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+          ck_assert_double_eq_tol(m2.matrix[i][j], i == j, 1e-12);
+        }
+      }
+      s21_remove_matrix(&vt);
+      s21_remove_matrix(&m2);
+      s21_remove_matrix(&Q);
+      s21_remove_matrix(&R);
+    } else {
+      ck_assert_int_eq(result, CALCERR);
+    }
+
+    s21_remove_matrix(&U);
+    s21_remove_matrix(&S);
+    s21_remove_matrix(&V);
+    s21_remove_matrix(&m1);
+  }
+
+  // sizes past one reflector and jacobi block
+  s21_create_matrix(70, 45, &m1);
+  s21_create_matrix(45, 45, &m2);
+  for (int i = 0; i < 70; i++) {
+    for (int j = 0; j < 45; j++) {
+      m1.matrix[i][j] = sin(i * 0.7 + j * 1.3 + 0.5);
+      if (i < 45) {
+        m2.matrix[i][j] = cos((i + 1.0) * (j + 1.0));
+      }
+    }
+  }
+  result = s21_eigen_symmetric(&m2, &values, &vectors, &iterations);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_lt(max_orthogonality_error(&vectors), 1e-12);
+  s21_create_matrix(45, 45, &scaled);
+  for (int i = 0; i < 45; i++) {
+    for (int j = 0; j < 45; j++) {
+      scaled.matrix[i][j] = values.matrix[i][0] * vectors.matrix[j][i];
+    }
+  }
+  ck_assert_double_lt(max_reconstruction_error(&m2, &vectors, &scaled),
+                      1e-12);
+  s21_remove_matrix(&scaled);
+  s21_remove_matrix(&values);
+  s21_remove_matrix(&vectors);
+
+  result = s21_svd_matrix(&m1, &U, &S, &V, &iterations);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_lt(max_orthogonality_error(&U), 1e-12);
+  ck_assert_double_lt(max_orthogonality_error(&V), 1e-12);
+  s21_remove_matrix(&U);
+  s21_remove_matrix(&S);
+  s21_remove_matrix(&V);
+
+  result = s21_qr_matrix(&m1, &Q, &R);
+  ck_assert_int_eq(result, OK);
+  ck_assert_double_lt(max_reconstruction_error(&m1, &Q, &R), 1e-12);
+  ck_assert_double_lt(max_orthogonality_error(&Q), 1e-12);
+  s21_remove_matrix(&Q);
+  s21_remove_matrix(&R);
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+
+  // a zero column and a dependent one still give orthonormal factors, tall
+  // and wide
+  for (int t = 0; t < 2; t++) {
+    s21_create_matrix(6, 4, &m2);
+    for (int i = 0; i < 6; i++) {
+      m2.matrix[i][0] = i + 1;
+      m2.matrix[i][1] = cos(i);
+      m2.matrix[i][2] = 0;
+      m2.matrix[i][3] = m2.matrix[i][0] + m2.matrix[i][1];
+    }
+    if (t) {
+      s21_transpose(&m2, &m1);
+    } else {
+      s21_copy_matrix(&m2, &m1);
+    }
+    result = s21_svd_matrix(&m1, &U, &S, &V, &iterations);
+    ck_assert_int_eq(result, OK);
+    ck_assert_double_eq(S.matrix[3][0], 0);
+    ck_assert_double_lt(max_orthogonality_error(&U), 1e-12);
+    ck_assert_double_lt(max_orthogonality_error(&V), 1e-12);
+    s21_create_matrix(4, V.rows, &scaled);
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < V.rows; j++) {
+        scaled.matrix[i][j] = S.matrix[i][0] * V.matrix[j][i];
+      }
+    }
+    ck_assert_double_lt(max_reconstruction_error(&m1, &U, &scaled), 1e-12);
+    s21_remove_matrix(&scaled);
+    s21_remove_matrix(&U);
+    s21_remove_matrix(&S);
+    s21_remove_matrix(&V);
+    s21_remove_matrix(&m1);
+    s21_remove_matrix(&m2);
+  }
+
+  // rank one inputs whose second row or column collapses to rounding noise
+  // stop rotating instead of running out of sweeps
+  double wide[2][3] = {{0.92614673406336667, 0, 1.8522934681267333},
+                       {0.22898834733317464, 0, 0.45797669466634927}};
+  for (int t = 0; t < 201; t++) {
+    s21_create_matrix(2, t < 200 ? 2 : 3, &m1);
+    for (int i = 0; i < m1.rows; i++) {
+      for (int j = 0; j < m1.columns; j++) {
+        m1.matrix[i][j] = t < 200 ? (i + 1) * sin(t * 1.7 + j * 2.9 + 0.3)
+                                  : wide[i][j];
+      }
+    }
+    result = s21_svd_matrix(&m1, &U, &S, &V, &iterations);
+    ck_assert_int_eq(result, OK);
+    ck_assert_double_lt(S.matrix[1][0], 1e-15 * S.matrix[0][0]);
+    ck_assert_double_lt(max_orthogonality_error(&U), 1e-12);
+    ck_assert_double_lt(max_orthogonality_error(&V), 1e-12);
+    s21_create_matrix(2, V.rows, &scaled);
+    for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < V.rows; j++) {
+        scaled.matrix[i][j] = S.matrix[i][0] * V.matrix[j][i];
+      }
+    }
+    ck_assert_double_lt(max_reconstruction_error(&m1, &U, &scaled), 1e-12);
+    s21_remove_matrix(&scaled);
+    s21_remove_matrix(&U);
+    s21_remove_matrix(&S);
+    s21_remove_matrix(&V);
+    s21_remove_matrix(&m1);
+  }
+}
+END_TEST
+
+static void count_callback(s21_future_t *future, void *user) {
+  (void)future;
+  (*(int *)user)++;
+}
+
+START_TEST(s21_async_test) {
+  matrix_t m1, m2, m3, m4, m5, m6, m7, big, cofactors, operand, product;
+  s21_future_t *mult, *sum, *det_future, *bad, *after_bad, *queued[3], *slow;
+  struct timespec start, end;
+  s21_context_t *ctx;
+  s21_allocator_t counting = {counting_alloc, counting_release, &allocations};
+  int calls = 0;
+  double det = 0, dets[3];
+
+  s21_create_matrix(2, 2, &m1);
+  s21_create_matrix(2, 2, &m2);
+  s21_create_matrix(2, 2, &m4);
+  m1.matrix[0][0] = 1;
+  m1.matrix[0][1] = 2;
+  m1.matrix[1][0] = 3;
+  m1.matrix[1][1] = 4;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      m2.matrix[i][j] = i == j;
+      m4.matrix[i][j] = 1;
+    }
+  }
+
+  // C = A * B; D = C + E runs without returning to the caller in between;
+  // the op keeps ctx's allocator even though ctx changes right away
+  s21_context_create(&ctx);
+  s21_context_set_allocator(ctx, counting);
+  mult = s21_async_mult_matrix(ctx, &m1, &m2, &m3, NULL, 0);
+  ck_assert_ptr_nonnull(mult);
+  s21_context_set_threads(ctx, 1);
+  sum = s21_async_sum_matrix(NULL, &m3, &m4, &m5, &mult, 1);
+  ck_assert_ptr_nonnull(sum);
+  s21_future_then(sum, count_callback, &calls);
+
+  ck_assert_int_eq(s21_future_wait(sum), OK);
+  ck_assert_int_eq(s21_future_poll(mult), SUCCESS);
+  ck_assert_double_eq_tol(m5.matrix[0][0], 2, 1e-7);
+  ck_assert_double_eq_tol(m5.matrix[1][1], 5, 1e-7);
+  ck_assert_int_eq(calls, 1);
+  ck_assert_int_eq(allocations, 1);
+
+  // callbacks on a completed future run immediately
+  s21_future_then(mult, count_callback, &calls);
+  ck_assert_int_eq(calls, 2);
+
+  det_future = s21_async_determinant(NULL, &m5, &det, &sum, 1);
+  ck_assert_int_eq(s21_future_wait(det_future), OK);
+  ck_assert_double_eq_tol(det, -2, 1e-7);
+
+  // dependents of a failed op fail with its error and never run
+  s21_create_matrix(3, 3, &m6);
+  bad = s21_async_sum_matrix(NULL, &m1, &m6, &m7, &sum, 1);
+  after_bad = s21_async_inverse_matrix(NULL, &m7, &m7, &bad, 1);
+  ck_assert_int_eq(s21_future_wait(after_bad), CALCERR);
+  ck_assert_int_eq(s21_future_error(bad), CALCERR);
+
+  s21_future_release(mult);
+  s21_future_release(sum);
+  s21_future_release(det_future);
+  s21_future_release(bad);
+  s21_future_release(after_bad);
+
+  // shutdown runs queued ops to completion before the workers leave
+  s21_async_shutdown();
+  s21_async_init(1);
+  s21_create_matrix(150, 150, &big);
+  for (int i = 0; i < 150; i++) {
+    for (int j = 0; j < 150; j++) {
+      big.matrix[i][j] = (i == j) + 0.01 * cos(i * 5.0 + j);
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    queued[i] = s21_async_determinant(NULL, &big, &dets[i], NULL, 0);
+  }
+  s21_async_shutdown();
+  for (int i = 0; i < 3; i++) {
+    ck_assert_int_eq(s21_future_poll(queued[i]), SUCCESS);
+    ck_assert_int_eq(s21_future_wait(queued[i]), OK);
+    ck_assert_double_eq(dets[i], dets[0]);
+    s21_future_release(queued[i]);
+  }
+
+  // a product next to a long op on one of two workers finishes long before
+  // it, the busy worker's bands go to the caller and the idle worker
+  s21_async_init(2);
+  s21_remove_matrix(&big);
+  s21_create_matrix(80, 80, &big);
+  for (int i = 0; i < 80; i++) {
+    for (int j = 0; j < 80; j++) {
+      big.matrix[i][j] = (i == j) + 0.01 * cos(i * 5.0 + j);
+    }
+  }
+  s21_create_matrix(256, 256, &operand);
+  for (int i = 0; i < 256; i++) {
+    for (int j = 0; j < 256; j++) {
+      operand.matrix[i][j] = (i == j) + 0.01 * cos(i * 5.0 + j);
+    }
+  }
+  slow = s21_async_calc_complements(NULL, &big, &cofactors, NULL, 0);
+  // give a worker time to pick the long op up
+  timespec_get(&start, TIME_UTC);
+  do {
+    timespec_get(&end, TIME_UTC);
+  } while (end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) * 1e-9 <
+           0.05);
+  timespec_get(&start, TIME_UTC);
+  ck_assert_int_eq(s21_mult_matrix(&operand, &operand, &product), OK);
+  timespec_get(&end, TIME_UTC);
+  ck_assert_int_eq(s21_future_poll(slow), FAILURE);
+  ck_assert_double_lt(end.tv_sec - start.tv_sec +
+                          (end.tv_nsec - start.tv_nsec) * 1e-9,
+                      0.5);
+  ck_assert_int_eq(s21_future_wait(slow), OK);
+  s21_future_release(slow);
+  s21_async_shutdown();
+
+  s21_remove_matrix(&m1);
+  s21_remove_matrix(&m2);
+  s21_remove_matrix_ctx(ctx, &m3);
+  ck_assert_int_eq(allocations, 0);
+  s21_context_destroy(ctx);
+  s21_remove_matrix(&m4);
+  s21_remove_matrix(&m5);
+  s21_remove_matrix(&m6);
+  s21_remove_matrix(&big);
+  s21_remove_matrix(&cofactors);
+  s21_remove_matrix(&operand);
+  s21_remove_matrix(&product);
+}
+END_TEST
+
 Suite *s21_matrix_suite(void) {
   Suite *s;
   TCase *tc_core;
@@ -556,6 +1807,21 @@ Suite *s21_matrix_suite(void) {
   tcase_add_test(tc_core, s21_calc_complements_test);
   tcase_add_test(tc_core, s21_determinant_test);
   tcase_add_test(tc_core, s21_inverse_matrix_test);
+  tcase_add_test(tc_core, s21_solve_matrix_test);
+  tcase_add_test(tc_core, s21_blocked_lu_test);
+  tcase_add_test(tc_core, s21_fixed_matrix_test);
+  tcase_add_test(tc_core, s21_matrix_pow_test);
+  tcase_add_test(tc_core, s21_matrix_exp_test);
+  tcase_add_test(tc_core, s21_vector_test);
+  tcase_add_test(tc_core, s21_handle_test);
+  tcase_add_test(tc_core, s21_accumulation_test);
+  tcase_add_test(tc_core, s21_nonfinite_test);
+  tcase_add_test(tc_core, s21_copy_matrix_test);
+  tcase_add_test(tc_core, s21_hugepage_test);
+  tcase_add_test(tc_core, s21_inverse_cache_test);
+  tcase_add_test(tc_core, s21_decomposition_test);
+  tcase_add_test(tc_core, s21_context_test);
+  tcase_add_test(tc_core, s21_async_test);
   suite_add_tcase(s, tc_core);
 
   return s;